@@ -0,0 +1,254 @@
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "graphics/instanced_mesh_renderer/instanced_mesh_renderer.hpp"
+
+namespace {
+
+const int image_size_px = 800;
+
+/**
+ * @brief makes a 3.3 core context current without a window or a display server, so this runs on a headless machine
+ * the same as on a desktop
+ *
+ * @return false if there's no EGL driver that can do it
+ */
+bool make_offscreen_context_current() {
+    auto get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display == nullptr) {
+        return false;
+    }
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY or not eglInitialize(display, nullptr, nullptr)) {
+        return false;
+    }
+
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                        EGL_NONE};
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if (not eglChooseConfig(display, config_attributes, &config, 1, &num_configs) or num_configs == 0) {
+        return false;
+    }
+    const EGLint surface_attributes[] = {EGL_WIDTH, image_size_px, EGL_HEIGHT, image_size_px, EGL_NONE};
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attributes);
+
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                         EGL_NONE};
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (surface == EGL_NO_SURFACE or context == EGL_NO_CONTEXT or
+        not eglMakeCurrent(display, surface, surface, context)) {
+        return false;
+    }
+    return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress));
+}
+
+glm::mat4 translation(float x, float y) {
+    glm::mat4 matrix(1.0f);
+    matrix[0] = glm::vec4(1, 0, 0, 0);
+    matrix[1] = glm::vec4(0, 1, 0, 0);
+    matrix[2] = glm::vec4(0, 0, 1, 0);
+    matrix[3] = glm::vec4(x, y, 0, 1);
+    return matrix;
+}
+
+GLuint compile_shader(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+/**
+ * @brief what drawing the squares used to come down to, queue_draw and draw_everything set the color and transform
+ * uniforms, uploaded the square's vertices and indices again and made a draw call, once per square per frame
+ *
+ * @note the batcher and shader cache live in submodules, so this does the same gl calls with the same shader inline
+ */
+class PerSquareRenderer {
+  public:
+    PerSquareRenderer(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices)
+        : vertices(vertices), indices(indices) {
+        shader_program = glCreateProgram();
+        glAttachShader(shader_program, compile_shader(GL_VERTEX_SHADER, R"(#version 330 core
+layout(location = 0) in vec3 position;
+uniform mat4 camera_to_clip;
+uniform mat4 world_to_camera;
+uniform mat4 local_to_world;
+void main() { gl_Position = camera_to_clip * world_to_camera * local_to_world * vec4(position, 1.0); }
+)"));
+        glAttachShader(shader_program, compile_shader(GL_FRAGMENT_SHADER, R"(#version 330 core
+uniform vec4 rgba_color;
+out vec4 frag_color;
+void main() { frag_color = rgba_color; }
+)"));
+        glLinkProgram(shader_program);
+        camera_to_clip_location = glGetUniformLocation(shader_program, "camera_to_clip");
+        world_to_camera_location = glGetUniformLocation(shader_program, "world_to_camera");
+        local_to_world_location = glGetUniformLocation(shader_program, "local_to_world");
+        rgba_color_location = glGetUniformLocation(shader_program, "rgba_color");
+
+        glGenVertexArrays(1, &vertex_array);
+        glBindVertexArray(vertex_array);
+        glGenBuffers(1, &vertex_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+        glGenBuffers(1, &index_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+        glBindVertexArray(0);
+    }
+
+    void draw(std::span<const InstancedMeshRenderer::Instance> instances, const glm::mat4 &world_to_clip) {
+        glm::mat4 identity(1.0f);
+        glUseProgram(shader_program);
+        glUniformMatrix4fv(camera_to_clip_location, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+        glUniformMatrix4fv(world_to_camera_location, 1, GL_FALSE, glm::value_ptr(identity));
+        glBindVertexArray(vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        for (const InstancedMeshRenderer::Instance &instance : instances) {
+            glUniform4fv(rgba_color_location, 1, glm::value_ptr(instance.color));
+            glUniformMatrix4fv(local_to_world_location, 1, GL_FALSE, glm::value_ptr(instance.local_to_world));
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(glm::vec3), vertices.data());
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+        }
+        glBindVertexArray(0);
+    }
+
+  private:
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> indices;
+    GLuint shader_program = 0;
+    GLint camera_to_clip_location = -1;
+    GLint world_to_camera_location = -1;
+    GLint local_to_world_location = -1;
+    GLint rgba_color_location = -1;
+    GLuint vertex_array = 0;
+    GLuint vertex_buffer = 0;
+    GLuint index_buffer = 0;
+};
+
+/**
+ * @brief lays num_squares out on a 100 wide grid over the whole image, the way remote characters fill the screen
+ */
+void fill_instances(unsigned int num_squares, std::vector<InstancedMeshRenderer::Instance> &instances) {
+    instances.clear();
+    for (unsigned int i = 0; i < num_squares; i++) {
+        instances.push_back({translation((i % 100) / 50.0f - 1, (i / 100 % 100) / 50.0f - 1), glm::vec4(1, 1, 0, 1)});
+    }
+}
+
+std::vector<unsigned char> read_image() {
+    std::vector<unsigned char> pixels(image_size_px * image_size_px * 4);
+    glReadPixels(0, 0, image_size_px, image_size_px, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+struct FrameTimes {
+    // until the last gl call returns, what the render thread spends
+    double submit;
+    // until the gpu has finished drawing too
+    double frame;
+};
+
+/**
+ * @brief builds the instances and draws them num_frames times, building them is included since the per square path
+ * had to walk the characters every frame too
+ */
+template <typename Draw> FrameTimes time_frames(unsigned int num_squares, unsigned int num_frames, Draw &&draw) {
+    std::vector<InstancedMeshRenderer::Instance> instances;
+    FrameTimes total{0, 0};
+    for (unsigned int frame = 0; frame < num_frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        glClear(GL_COLOR_BUFFER_BIT);
+        fill_instances(num_squares, instances);
+        draw(instances);
+        auto submitted = std::chrono::steady_clock::now();
+        glFinish();
+        auto finished = std::chrono::steady_clock::now();
+        total.submit += std::chrono::duration<double>(submitted - start).count();
+        total.frame += std::chrono::duration<double>(finished - start).count();
+    }
+    return {total.submit / num_frames, total.frame / num_frames};
+}
+
+} // namespace
+
+/**
+ * @brief renders 3, 100, 1000 and 10000 squares offscreen a draw call per square like the client used to and in one
+ * instanced draw call, and reports the cpu time to submit a frame and the time until it's drawn
+ *
+ * @note with a software driver like llvmpipe the gpu side is cpu time too, so the submit time is the number to compare
+ * and the frame time is only meaningful on real hardware. Both paths are checked to draw the same image first
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        std::cout << "usage: " << argv[0] << " [num_frames]" << std::endl;
+        return 1;
+    }
+    unsigned int num_frames = argc > 1 ? std::stoul(argv[1]) : 200;
+
+    if (not make_offscreen_context_current()) {
+        std::cout << "couldn't make an offscreen 3.3 core context current" << std::endl;
+        return 1;
+    }
+    std::cout << std::format("renderer: {}\n", reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+
+    // what generate_square_vertices(0, 0, .5) and generate_square_indices give the client
+    const float half_width = 0.25f;
+    std::vector<glm::vec3> square_vertices = {{half_width, half_width, 0},
+                                              {half_width, -half_width, 0},
+                                              {-half_width, -half_width, 0},
+                                              {-half_width, half_width, 0}};
+    std::vector<unsigned int> square_indices = {0, 1, 3, 1, 2, 3};
+    PerSquareRenderer per_square_renderer(square_vertices, square_indices);
+    InstancedMeshRenderer instanced_renderer(square_vertices, square_indices);
+    glm::mat4 world_to_clip(1.0f);
+    // outlines only, so squares that overlap still all show up and change the image if one goes missing
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+    std::vector<InstancedMeshRenderer::Instance> instances;
+    fill_instances(50, instances);
+    glClear(GL_COLOR_BUFFER_BIT);
+    per_square_renderer.draw(instances, world_to_clip);
+    std::vector<unsigned char> per_square_image = read_image();
+    glClear(GL_COLOR_BUFFER_BIT);
+    instanced_renderer.draw(instances, world_to_clip);
+    if (read_image() != per_square_image) {
+        std::cout << "the two renderers drew different images" << std::endl;
+        return 1;
+    }
+
+    for (unsigned int num_squares : {3u, 100u, 1000u, 10000u}) {
+        FrameTimes per_square = time_frames(num_squares, num_frames, [&](const auto &instances) {
+            per_square_renderer.draw(instances, world_to_clip);
+        });
+        FrameTimes instanced = time_frames(num_squares, num_frames, [&](const auto &instances) {
+            instanced_renderer.draw(instances, world_to_clip);
+        });
+        std::cout << std::format("{:>5} squares: per square submit {:>8.3f}ms frame {:>8.3f}ms, instanced submit "
+                                 "{:>7.3f}ms frame {:>7.3f}ms\n",
+                                 num_squares, 1000 * per_square.submit, 1000 * per_square.frame,
+                                 1000 * instanced.submit, 1000 * instanced.frame);
+    }
+    return 0;
+}
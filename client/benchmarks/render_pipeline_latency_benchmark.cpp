@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utility/triple_buffer/triple_buffer.hpp"
+
+namespace {
+
+const double loop_period = 1.0 / 512;
+const double step_period = 1.0 / 60;
+const double vblank_period = 1.0 / 60;
+
+double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// stands in for work, busy rather than sleeping so it holds the thread like the real thing
+void spin_for(double seconds) {
+    double end = now_seconds() + seconds;
+    while (now_seconds() < end) {
+    }
+}
+
+void sleep_until(double time) {
+    std::chrono::duration<double> remaining(time - now_seconds());
+    if (remaining.count() > 0) {
+        std::this_thread::sleep_for(remaining);
+    }
+}
+
+/**
+ * @brief when the player changes which keys they hold, seeded so every run gets the same presses
+ */
+std::vector<double> generate_key_changes(double start, double duration) {
+    std::mt19937_64 random_engine(7);
+    std::exponential_distribution<double> gap(1 / 0.15);
+    std::vector<double> key_changes;
+    for (double time = start + 0.2; time < start + duration - 0.2; time += gap(random_engine)) {
+        key_changes.push_back(time);
+    }
+    return key_changes;
+}
+
+/**
+ * @brief rendering with the gpu stubbed out, building a frame takes half a millisecond, the driver hitches for 30ms
+ * once a second and with vsync on swapping waits for the next vblank
+ */
+class HeadlessRenderer {
+  public:
+    HeadlessRenderer(bool vsync, double start) : vsync(vsync), next_hitch(start + 0.5), next_vblank(start) {}
+
+    void render_frame() {
+        spin_for(0.0005);
+        double now = now_seconds();
+        if (now >= next_hitch) {
+            sleep_until(now + 0.030);
+            next_hitch += 1;
+        }
+        if (vsync) {
+            now = now_seconds();
+            while (next_vblank <= now) {
+                next_vblank += vblank_period;
+            }
+            sleep_until(next_vblank);
+        }
+    }
+
+  private:
+    bool vsync;
+    double next_hitch;
+    double next_vblank;
+};
+
+struct LatencyAndJitter {
+    // from a key changing to the first simulation step that used it
+    std::vector<double> input_latencies;
+    // how far the time between consecutive steps strayed from the step period
+    std::vector<double> step_jitters;
+};
+
+/**
+ * @brief the client's tick with networking stubbed out, dt is accumulated and a fixed step runs whenever a whole
+ * period has built up, the step reads whatever the input was at that moment
+ */
+class StubbedSimulation {
+  public:
+    void tick(double dt, double key_changed_at) {
+        spin_for(0.0001);
+        accumulated_time += dt;
+        if (accumulated_time < step_period) {
+            return;
+        }
+        accumulated_time -= step_period;
+        // a long stall drops the steps it missed rather than running them back to back
+        if (accumulated_time > step_period) {
+            accumulated_time = 0;
+        }
+        spin_for(0.0002);
+        double now = now_seconds();
+        if (key_changed_at > newest_key_change_stepped) {
+            newest_key_change_stepped = key_changed_at;
+            results.input_latencies.push_back(now - key_changed_at);
+        }
+        if (last_step_time >= 0) {
+            results.step_jitters.push_back(std::abs(now - last_step_time - step_period));
+        }
+        last_step_time = now;
+    }
+
+    LatencyAndJitter results;
+
+  private:
+    double accumulated_time = 0;
+    double last_step_time = -1;
+    double newest_key_change_stepped = 0;
+};
+
+/**
+ * @brief runs tick every loop period until duration has passed, falling behind resets the schedule rather than
+ * trying to catch up
+ */
+template <typename Tick> void run_loop(double start, double duration, Tick &&tick) {
+    double next_iteration = start;
+    double last_iteration = start;
+    while (now_seconds() < start + duration) {
+        double now = now_seconds();
+        tick(now - last_iteration);
+        last_iteration = now;
+        next_iteration = std::max(next_iteration + loop_period, now_seconds());
+        sleep_until(next_iteration);
+    }
+}
+
+/**
+ * @brief how the client used to run, ticking, rendering and then polling events all on one thread, so input is only
+ * noticed once the frame is done and a stalled frame stalls the simulation with it
+ */
+LatencyAndJitter run_serial(bool vsync, double duration) {
+    double start = now_seconds();
+    std::vector<double> key_changes = generate_key_changes(start, duration);
+    size_t next_key_change = 0;
+    double key_changed_at = 0;
+    StubbedSimulation simulation;
+    HeadlessRenderer renderer(vsync, start);
+    run_loop(start, duration, [&](double dt) {
+        simulation.tick(dt, key_changed_at);
+        renderer.render_frame();
+        // key changes are stamped with when they happened rather than when they were polled, so the time spent
+        // waiting to be polled counts towards the latency
+        double now = now_seconds();
+        for (; next_key_change < key_changes.size() and key_changes[next_key_change] <= now; next_key_change++) {
+            key_changed_at = key_changes[next_key_change];
+        }
+    });
+    return simulation.results;
+}
+
+/**
+ * @brief how the client runs now, the simulation on its own thread publishing render snapshots through a triple
+ * buffer, rendering on another and the main thread waiting on events and handing input over as it arrives
+ */
+LatencyAndJitter run_pipelined(double duration, double &frames_per_second) {
+    struct RenderSnapshot {
+        std::vector<float> instances;
+    };
+
+    double start = now_seconds();
+    std::vector<double> key_changes = generate_key_changes(start, duration);
+    std::atomic<double> key_changed_at = 0;
+    std::atomic<bool> running = true;
+    TripleBuffer<RenderSnapshot> render_snapshots;
+    StubbedSimulation simulation;
+
+    std::thread simulation_thread([&]() {
+        run_loop(start, duration, [&](double dt) {
+            simulation.tick(dt, key_changed_at.load(std::memory_order_acquire));
+            render_snapshots.get_back_buffer().instances.assign(64, 1.0f);
+            render_snapshots.publish();
+        });
+    });
+    uint64_t num_frames = 0;
+    std::thread render_thread([&]() {
+        HeadlessRenderer renderer(true, start);
+        while (running.load(std::memory_order_relaxed)) {
+            render_snapshots.consume();
+            volatile float drawn = render_snapshots.get_front_buffer().instances.empty()
+                                       ? 0
+                                       : render_snapshots.get_front_buffer().instances[0];
+            (void)drawn;
+            renderer.render_frame();
+            num_frames++;
+        }
+    });
+
+    // like glfwWaitEvents, the main thread wakes when a key changes and hands it over straight away
+    for (double key_change : key_changes) {
+        sleep_until(key_change);
+        key_changed_at.store(now_seconds(), std::memory_order_release);
+    }
+    simulation_thread.join();
+    running = false;
+    render_thread.join();
+    frames_per_second = num_frames / duration;
+    return simulation.results;
+}
+
+struct Percentiles {
+    double mean;
+    double p99;
+    double max;
+};
+
+Percentiles summarize(std::vector<double> values) {
+    if (values.empty()) {
+        return {0, 0, 0};
+    }
+    double total = 0;
+    for (double value : values) {
+        total += value;
+    }
+    std::sort(values.begin(), values.end());
+    return {total / values.size(), values[static_cast<size_t>(0.99 * (values.size() - 1))], values.back()};
+}
+
+void print(const std::string &name, const LatencyAndJitter &results) {
+    std::string latency_text = "no input,";
+    if (not results.input_latencies.empty()) {
+        Percentiles latency = summarize(results.input_latencies);
+        latency_text = std::format("input to simulation mean {:>6.2f}ms p99 {:>6.2f}ms max {:>6.2f}ms,",
+                                   1000 * latency.mean, 1000 * latency.p99, 1000 * latency.max);
+    }
+    Percentiles jitter = summarize(results.step_jitters);
+    std::cout << std::format("{:<20} {:<64} step jitter mean {:>5.2f}ms p99 {:>5.2f}ms max {:>6.2f}ms over {} "
+                             "steps\n",
+                             name, latency_text, 1000 * jitter.mean, 1000 * jitter.p99, 1000 * jitter.max,
+                             results.step_jitters.size());
+}
+
+} // namespace
+
+/**
+ * @brief how long a key change takes to reach a simulation step and how evenly steps are spaced, with the client's
+ * old single threaded loop against the one that simulates and renders on separate threads, rendering stubbed out by
+ * a headless renderer that hitches once a second the way a driver sometimes does
+ *
+ * @note main.cpp's tick needs a window, a server and physics, so both loops drive a stand in that does the same
+ * accumulation and fixed steps with spinning in place of the work. The simulation alone, with nothing rendering, is
+ * the floor either can reach
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        std::cout << "usage: " << argv[0] << " [seconds_per_run]" << std::endl;
+        return 1;
+    }
+    double duration = argc > 1 ? std::stod(argv[1]) : 20;
+
+    StubbedSimulation simulation_alone;
+    run_loop(now_seconds(), duration, [&](double dt) { simulation_alone.tick(dt, 0); });
+    print("simulation alone", simulation_alone.results);
+    print("serial, vsync off", run_serial(false, duration));
+    print("serial, vsync on", run_serial(true, duration));
+    double frames_per_second = 0;
+    LatencyAndJitter pipelined = run_pipelined(duration, frames_per_second);
+    print("pipelined, vsync on", pipelined);
+    std::cout << std::format("pipelined rendered {:.1f} frames per second\n", frames_per_second);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "instanced_mesh_renderer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+constexpr GLuint position_attribute = 0;
+// a mat4 attribute takes up four consecutive locations, one per column
+constexpr GLuint local_to_world_attribute = 1;
+constexpr GLuint color_attribute = 5;
+
+const char *vertex_shader_source = R"(#version 330 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in mat4 local_to_world;
+layout(location = 5) in vec4 color;
+
+uniform mat4 world_to_clip;
+
+out vec4 instance_color;
+
+void main() {
+    gl_Position = world_to_clip * local_to_world * vec4(position, 1.0);
+    instance_color = color;
+}
+)";
+
+const char *fragment_shader_source = R"(#version 330 core
+in vec4 instance_color;
+out vec4 frag_color;
+
+void main() { frag_color = instance_color; }
+)";
+
+GLuint compile_shader(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (not compiled) {
+        char info_log[1024];
+        glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+        glDeleteShader(shader);
+        throw std::runtime_error(std::string("instanced mesh shader failed to compile: ") + info_log);
+    }
+    return shader;
+}
+
+GLuint link_program(GLuint vertex_shader, GLuint fragment_shader) {
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (not linked) {
+        char info_log[1024];
+        glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+        glDeleteProgram(program);
+        throw std::runtime_error(std::string("instanced mesh shader failed to link: ") + info_log);
+    }
+    return program;
+}
+} // namespace
+
+InstancedMeshRenderer::InstancedMeshRenderer(const std::vector<glm::vec3> &vertices,
+                                             const std::vector<unsigned int> &indices)
+    : num_indices(static_cast<GLsizei>(indices.size())) {
+    shader_program = link_program(compile_shader(GL_VERTEX_SHADER, vertex_shader_source),
+                                  compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source));
+    world_to_clip_location = glGetUniformLocation(shader_program, "world_to_clip");
+
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(position_attribute);
+    glVertexAttribPointer(position_attribute, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+
+    glGenBuffers(1, &index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    // transforms and colors sit side by side in one buffer and advance once per instance instead of per vertex
+    glGenBuffers(1, &instance_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    for (GLuint column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(local_to_world_attribute + column);
+        glVertexAttribPointer(local_to_world_attribute + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              reinterpret_cast<const void *>(offsetof(Instance, local_to_world) +
+                                                             column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(local_to_world_attribute + column, 1);
+    }
+    glEnableVertexAttribArray(color_attribute);
+    glVertexAttribPointer(color_attribute, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                          reinterpret_cast<const void *>(offsetof(Instance, color)));
+    glVertexAttribDivisor(color_attribute, 1);
+
+    glBindVertexArray(0);
+}
+
+InstancedMeshRenderer::~InstancedMeshRenderer() {
+    glDeleteBuffers(1, &instance_buffer);
+    glDeleteBuffers(1, &index_buffer);
+    glDeleteBuffers(1, &vertex_buffer);
+    glDeleteVertexArrays(1, &vertex_array);
+    glDeleteProgram(shader_program);
+}
+
+void InstancedMeshRenderer::draw(std::span<const Instance> instances, const glm::mat4 &world_to_clip) {
+    if (instances.empty()) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    if (instances.size() > instance_buffer_capacity) {
+        instance_buffer_capacity = std::max(instances.size(), 2 * instance_buffer_capacity);
+    }
+    // handing over a fresh buffer every frame means we never wait on the gpu still reading last frame's instances
+    glBufferData(GL_ARRAY_BUFFER, instance_buffer_capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+
+    glUseProgram(shader_program);
+    glUniformMatrix4fv(world_to_clip_location, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+    glBindVertexArray(vertex_array);
+    glDrawElementsInstanced(GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, nullptr,
+                            static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+}
@@ -0,0 +1,50 @@
+#ifndef INSTANCED_MESH_RENDERER_HPP
+#define INSTANCED_MESH_RENDERER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+/**
+ * @brief draws any number of copies of one mesh with a single draw call, the mesh goes to the gpu once up front and
+ * each frame only sends a transform and a color per copy
+ *
+ * @note the shader cache and batcher only draw one transform at a time, so this compiles its own small shader, it
+ * does the same thing as CWL_V_TRANSFORMATION_WITH_SOLID_COLOR but reads the transform and color per instance
+ */
+class InstancedMeshRenderer {
+  public:
+    struct Instance {
+        glm::mat4 local_to_world;
+        glm::vec4 color;
+    };
+
+    /**
+     * @throws std::runtime_error if the shader doesn't compile, which only happens without a 3.3 context
+     */
+    InstancedMeshRenderer(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices);
+    ~InstancedMeshRenderer();
+
+    InstancedMeshRenderer(const InstancedMeshRenderer &) = delete;
+    InstancedMeshRenderer &operator=(const InstancedMeshRenderer &) = delete;
+
+    /**
+     * @param world_to_clip camera_to_clip * world_to_camera
+     */
+    void draw(std::span<const Instance> instances, const glm::mat4 &world_to_clip);
+
+  private:
+    GLuint shader_program = 0;
+    GLint world_to_clip_location = -1;
+    GLuint vertex_array = 0;
+    GLuint vertex_buffer = 0;
+    GLuint index_buffer = 0;
+    GLsizei num_indices = 0;
+    GLuint instance_buffer = 0;
+    // in instances, grows to fit the most ever drawn at once and never shrinks
+    size_t instance_buffer_capacity = 0;
+};
+
+#endif // INSTANCED_MESH_RENDERER_HPP
@@ -1,67 +1,95 @@
-#include "graphics/shader_cache/shader_cache.hpp"
 #include "graphics/vertex_geometry/vertex_geometry.hpp"
 #include "graphics/window/window.hpp"
 #include "graphics/transform/transform.hpp"
-#include "graphics/batcher/generated/batcher.hpp"
+#include "graphics/instanced_mesh_renderer/instanced_mesh_renderer.hpp"
 #include "graphics/glfw_lambda_callback_manager/glfw_lambda_callback_manager.hpp"
 
 #include "system_logic/physics/physics.hpp"
+#include "system_logic/character_update/character_update.hpp"
+#include "system_logic/client_simulation/client_simulation.hpp"
 
 #include "networking/client_networking/network.hpp"
+#include "networking/messages/messages.hpp"
 
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <format>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <thread>
 
 #include "utility/fixed_frequency_loop/fixed_frequency_loop.hpp"
-#include "utility/fixed_frequency_reprocessor/fixed_frequency_reprocessor.hpp"
 #include "utility/periodic_signal/periodic_signal.hpp"
 #include "utility/input_state/input_state.hpp"
 #include "utility/rate_limited_function/rate_limited_function.hpp"
 #include "utility/jolt_glm_type_conversions/jolt_glm_type_conversions.hpp"
+#include "utility/triple_buffer/triple_buffer.hpp"
+#include "utility/tracing/tracing.hpp"
+#include "utility/metrics/metrics.hpp"
+#include "utility/capture/capture.hpp"
 
 #include <GLFW/glfw3.h>
 #include <iostream>
 
-struct GameUpdate {
-    double position_x;
-    double position_y;
-    double velocity_x;
-    double velocity_y;
-
-    int last_id_used_to_produce_this_update;
-
-    // Overloading the << operator
-    friend std::ostream &operator<<(std::ostream &os, const GameUpdate &update) {
-        os << "GameUpdate { position: " << update.position_x << ", " << update.position_y
-           << ", last_id_used_to_produce_this_update: " << update.last_id_used_to_produce_this_update << " }";
-        return os;
-    }
+// how often our own character is stepped, matching the server so predictions line up, the rest of prediction and
+// reconciliation is configured through ClientSimulation::Settings
+constexpr unsigned int client_simulation_rate_hz = 60;
+constexpr double client_simulation_period = 1.0 / client_simulation_rate_hz;
+// how often the simulation thread polls the network and publishes a frame to draw, input is only made once per
+// simulation step, this just keeps the step on time
+constexpr unsigned int simulation_thread_rate_hz = 512;
+
+/**
+ * @brief everything the render thread needs to draw a frame, the simulation thread fills one in every tick and never
+ * touches it again once it's published
+ */
+struct RenderSnapshot {
+    std::vector<InstancedMeshRenderer::Instance> square_instances;
 };
 
-struct KeyboardUpdate {
-    int id;
-    bool forward_pressed = false;
-    bool backwards_pressed = false;
-    bool left_pressed = false;
-    bool right_pressed = false;
-
-    friend std::ostream &operator<<(std::ostream &os, const KeyboardUpdate &update) {
-        os << "KeyboardUpdate{id: " << update.id << ", forward_pressed: " << update.forward_pressed
-           << ", backwards_pressed: " << update.backwards_pressed << ", left_pressed: " << update.left_pressed
-           << ", right_pressed: " << update.right_pressed << "}";
-        return os;
+// the low bits of the published input are the held movement keys, the rest is when they last changed in microseconds
+constexpr uint64_t forward_key_bit = 1 << 0;
+constexpr uint64_t backwards_key_bit = 1 << 1;
+constexpr uint64_t left_key_bit = 1 << 2;
+constexpr uint64_t right_key_bit = 1 << 3;
+constexpr int input_timestamp_shift = 4;
+
+int main(int argc, char *argv[]) {
+    // --record writes every packet and input to a capture, --replay runs one back as fast as possible without a
+    // window or a connection, --one-packet-per-input sends each input on its own instead of resending everything the
+    // server hasn't acknowledged, to compare bandwidth against, --reconcile-every-update keeps every game update read
+    // in a tick rather than dropping older ones as they're read
+    std::optional<std::string> record_path;
+    std::optional<std::string> replay_path;
+    bool send_unacknowledged_input_window = true;
+    bool reconcile_against_newest_update_only = true;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--record" and i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (argument == "--replay" and i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (argument == "--one-packet-per-input") {
+            send_unacknowledged_input_window = false;
+        } else if (argument == "--reconcile-every-update") {
+            reconcile_against_newest_update_only = false;
+        } else {
+            valid_arguments = false;
+        }
     }
-};
-
-constexpr bool printing_active = true;
-void p(std::string s) {
-    if (printing_active) {
-        std::cout << s << std::endl;
+    if (not valid_arguments or (record_path.has_value() and replay_path.has_value())) {
+        std::cout << "usage: " << argv[0]
+                  << " [--record <capture> | --replay <capture>] [--one-packet-per-input] [--reconcile-every-update]"
+                  << std::endl;
+        return 1;
     }
-}
-
-int main() {
+    bool replaying = replay_path.has_value();
 
     Physics physics;
 
@@ -80,44 +108,75 @@ int main() {
     unsigned int screen_height_px = 800;
     bool start_in_fullscreen = false;
     bool start_with_mouse_captured = false;
-    bool vsync = false;
+    // drawing has its own thread now, so it can wait on the display without holding up the simulation
+    bool vsync = true;
 
     Transform client_only_transform;
     Transform server_only_transform;
 
-    Transform transform;
-    float acceleration = 10 * 0.01;
-    float friction = 0.99;
-    glm::vec2 current_velocity(0);
-
-    std::unordered_map<int, glm::vec2> id_to_position;
-    std::unordered_map<int, KeyboardUpdate> id_to_keyboard_update;
+    // predicts, sends and reconciles our own character and keeps track of everyone near it, the same code the
+    // simulation harness runs
+    ClientSimulation::Settings client_simulation_settings;
+    client_simulation_settings.simulation_period = client_simulation_period;
+    client_simulation_settings.send_unacknowledged_input_window = send_unacknowledged_input_window;
+    client_simulation_settings.reconcile_against_newest_update_only = reconcile_against_newest_update_only;
+    ClientSimulation client_simulation(client_simulation_settings, physics.physics_system, cpsr_character);
 
     Window window;
-    window.initialize_glfw_glad_and_return_window(screen_width_px, screen_height_px, "mwe_cpsr", start_in_fullscreen,
-                                                  start_with_mouse_captured, vsync);
+    if (not replaying) {
+        window.initialize_glfw_glad_and_return_window(screen_width_px, screen_height_px, "mwe_cpsr",
+                                                      start_in_fullscreen, start_with_mouse_captured, vsync);
+    }
 
     InputState input_state;
 
+    // the movement keys and when they last changed, written by the event thread the moment a key changes and read by
+    // the simulation thread whenever it samples input, so input never waits on a frame being drawn
+    std::atomic<uint64_t> published_input = 0;
+    uint64_t held_movement_keys = 0;
+    auto get_movement_key_bit = [](int key) -> uint64_t {
+        switch (key) {
+        case GLFW_KEY_W:
+            return forward_key_bit;
+        case GLFW_KEY_S:
+            return backwards_key_bit;
+        case GLFW_KEY_A:
+            return left_key_bit;
+        case GLFW_KEY_D:
+            return right_key_bit;
+        default:
+            return 0;
+        }
+    };
+
     // TODO debugging why keys aren't being picked up for some reason
-    std::function<void(unsigned int)> char_callback = [](unsigned int codepoint) {};
-    std::function<void(int, int, int, int)> key_callback = [&](int key, int scancode, int action, int mods) {
+    std::function<void(unsigned int)> char_callback = [](unsigned int) {};
+    std::function<void(int, int, int, int)> key_callback = [&](int key, int, int action, int) {
         if (action == GLFW_PRESS || action == GLFW_RELEASE) {
             Key &active_key = *input_state.glfw_code_to_key.at(key);
             bool is_pressed = (action == GLFW_PRESS);
             active_key.pressed_signal.set_signal(is_pressed);
+
+            uint64_t movement_key_bit = get_movement_key_bit(key);
+            if (movement_key_bit != 0) {
+                held_movement_keys = is_pressed ? held_movement_keys | movement_key_bit
+                                                : held_movement_keys & ~movement_key_bit;
+                uint64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                            std::chrono::steady_clock::now().time_since_epoch())
+                                            .count();
+                published_input.store(timestamp_us << input_timestamp_shift | held_movement_keys,
+                                      std::memory_order_release);
+            }
         }
     };
-    std::function<void(double, double)> mouse_pos_callback = [](double xpos, double ypos) {};
-    std::function<void(int, int, int)> mouse_button_callback = [](int button, int action, int mods) {};
-    GLFWLambdaCallbackManager glcm(window.glfw_window, char_callback, key_callback, mouse_pos_callback,
-                                   mouse_button_callback);
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    std::vector<ShaderType> requested_shaders = {ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR};
-    ShaderCache shader_cache(requested_shaders);
-    Batcher batcher(shader_cache);
+    std::function<void(double, double)> mouse_pos_callback = [](double, double) {};
+    std::function<void(int, int, int)> mouse_button_callback = [](int, int, int) {};
+    std::unique_ptr<GLFWLambdaCallbackManager> glcm;
+    if (not replaying) {
+        glcm = std::make_unique<GLFWLambdaCallbackManager>(window.glfw_window, char_callback, key_callback,
+                                                           mouse_pos_callback, mouse_button_callback);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
 
     auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     console_sink->set_level(spdlog::level::debug);
@@ -128,191 +187,305 @@ int main() {
     std::string local_network = "localhost";
     std::string ubuntu_sfo = "147.182.197.23";
     Network network(local_network, 7777, sinks);
-    network.initialize_network();
-    network.attempt_to_connect_to_server();
-
-    double velocity = 1;
-
-    auto client_process = [&](int id, double dt, bool reprocessing_call) {
-        KeyboardUpdate ku = id_to_keyboard_update[id];
-        glm::vec2 input_vector(static_cast<int>(ku.right_pressed) - static_cast<int>(ku.left_pressed),
-                               static_cast<int>(ku.forward_pressed) - static_cast<int>(ku.backwards_pressed));
-        std::string result = std::format("Input Vector: ({}, {})", input_vector.x, input_vector.y);
-        p(result);
-
-        glm::vec3 input_vector_3d(input_vector, 0);
-        auto new_velocity =
-            cpsr_character->GetLinearVelocity() + g2j(input_vector_3d * acceleration * static_cast<float>(dt));
-        new_velocity *= friction;
-        cpsr_character->SetLinearVelocity(new_velocity);
-        current_velocity = j2g(cpsr_character->GetLinearVelocity());
-        physics.update_specific_character(dt, cpsr_character);
-        transform.position = j2g(cpsr_character->GetPosition());
-        p(std::format("Before processing: Client ID: {} with dt: {} - Position: ({}, {})", id, dt, transform.position.x,
-                      transform.position.y));
-
-        if (not reprocessing_call) {
-            client_only_character->SetLinearVelocity(new_velocity);
-            physics.update_specific_character(dt, client_only_character);
-            client_only_transform.position = j2g(client_only_character->GetLinearVelocity());
-        }
+    if (not replaying) {
+        network.initialize_network();
+    }
+    tracing::start_tracing(sinks);
+    metrics::start_exporting({"client_metrics.csv", "client_metrics.json"});
+
+    metrics::Histogram &tick_duration_ms = metrics::get_histogram("tick_duration_ms");
+    metrics::Histogram &input_to_simulation_ms = metrics::get_histogram("input_to_simulation_ms");
+    metrics::Histogram &simulation_step_jitter_ms = metrics::get_histogram("simulation_step_jitter_ms");
+    metrics::Histogram &sent_packet_bytes = metrics::get_histogram("sent_packet_bytes");
+    metrics::Histogram &received_packet_bytes = metrics::get_histogram("received_packet_bytes");
+    if (not replaying) {
+        network.attempt_to_connect_to_server();
+    }
 
-        id_to_position[id] = transform.position;
+    std::unique_ptr<capture::CaptureWriter> capture_writer;
+    if (record_path.has_value()) {
+        capture_writer = std::make_unique<capture::CaptureWriter>(record_path.value());
+        spdlog::info("recording everything received and every input to {}", record_path.value());
+    }
+    std::unique_ptr<capture::CaptureReader> capture_reader;
+    if (replaying) {
+        capture_reader = std::make_unique<capture::CaptureReader>(replay_path.value());
+    }
+    // when the tick being replayed started and what came in during it, read from the capture before each tick
+    double replay_tick_time = 0;
+    std::vector<capture::Record> replay_records;
 
-        result = std::format("Client Processing ID: {} with dt: {} - New Position: ({}, {})", id, dt,
-                             id_to_position[id].x, id_to_position[id].y);
-        p(result);
-    };
+    // the blue debug square is stepped on its own with whatever velocity we predicted, it's never reconciled
+    JPH::TempAllocatorImpl temp_allocator(1024 * 1024);
 
-    auto reprocess_function = [&](int id) {
-        /*if (id_to_position.find(id) != id_to_position.end()) {*/
-        /*    client_position = id_to_position[id];*/
-        /*    std::cout << "Client Reprocessing ID: " << id << " - Position set to " << client_position <<
-         * std::endl;*/
-        /*}*/
+    // a replay runs on the clock it was recorded with, so everything timed against it plays out the same
+    auto get_local_time = [&]() {
+        if (replaying) {
+            return replay_tick_time;
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
     };
 
-    int curr_id = 0;
-
-    std::vector<KeyboardUpdate> kus_since_last_cts_send;
-
-    FixedFrequencyReprocessor client_physics(60, client_process, reprocess_function);
-    PeriodicSignal send_signal(60);
+    // how long key changes waited to be simulated and how evenly simulation steps were spaced, logged once a second
+    double newest_simulated_input_change = 0;
+    uint64_t num_input_changes_simulated_since_stats = 0;
+    double total_input_latency_since_stats = 0;
+    double max_input_latency_since_stats = 0;
+    std::optional<double> last_simulation_step_time;
+    uint64_t num_simulation_steps_since_stats = 0;
+    double total_simulation_step_jitter_since_stats = 0;
+    double max_simulation_step_jitter_since_stats = 0;
+
+    std::vector<RemoteCharacterInterpolator::RemoteCharacter> remote_characters;
+
+    PeriodicSignal reconciliation_stats_signal(1);
+    uint64_t num_replays_since_stats = 0;
+    uint64_t num_ticks_replayed_since_stats = 0;
+    double replay_time_since_stats = 0;
+    uint64_t num_replays_skipped_since_stats = 0;
+    uint64_t num_ticks_not_replayed_since_stats = 0;
 
     std::vector<glm::vec3> square_vertices = vertex_geometry::generate_square_vertices(0, 0, .5);
     std::vector<unsigned int> square_indices = vertex_geometry::generate_square_indices();
 
-    shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR, ShaderUniformVariable::CAMERA_TO_CLIP,
-                             glm::mat4(1.0f));
-    shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR, ShaderUniformVariable::WORLD_TO_CAMERA,
-                             glm::mat4(1.0f));
-    shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR, ShaderUniformVariable::LOCAL_TO_WORLD,
-                             glm::mat4(1.0f));
+    // every character is the same square, so they all go out in one draw with a transform and color each
+    // a replay never draws and has no gl context to make one in
+    std::unique_ptr<InstancedMeshRenderer> square_renderer;
+    if (not replaying) {
+        square_renderer = std::make_unique<InstancedMeshRenderer>(square_vertices, square_indices);
+    }
+    // there's no camera yet, world space is clip space
+    glm::mat4 world_to_clip(1.0f);
 
-    std::function<bool()> termination = [&]() { return glfwWindowShouldClose(window.glfw_window); };
-    std::function<void(double)> tick = [&](double dt) {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // the simulation thread publishes what to draw every tick and the render thread draws the newest whenever the
+    // display is ready for another frame
+    TripleBuffer<RenderSnapshot> render_snapshots;
 
-        p("=== TICK START ===");
-        client_physics.add_id(curr_id);
-        KeyboardUpdate ku(curr_id, input_state.is_pressed(EKey::w), input_state.is_pressed(EKey::s),
-                          input_state.is_pressed(EKey::a), input_state.is_pressed(EKey::d));
+    std::atomic<bool> running = true;
 
-        id_to_keyboard_update[curr_id] = ku;
-        kus_since_last_cts_send.push_back(ku);
+    uint64_t tick_id = 0;
+    // the packets being handled this tick, pointing into either what the network handed us or the capture
+    std::vector<PacketWithSize> received_packets;
+    std::vector<std::span<const char>> packets_this_tick;
 
-        if (client_physics.attempt_to_process()) {
-            p("^^^ just processed ^^^");
+    std::function<bool()> termination = [&]() { return not running.load(std::memory_order_acquire); };
+    std::function<void(double)> tick = [&](double dt) {
+        auto tick_started_at = std::chrono::steady_clock::now();
+        double tick_start = get_local_time();
+        TRACE_TRACE("=== TICK START ===");
+        if (capture_writer) {
+            capture_writer->begin_tick(tick_id, dt, tick_start);
         }
-
-        if (send_signal.process_and_get_signal()) {
-            for (const auto &ku : kus_since_last_cts_send) {
-                p("^^^ just processed ^^^");
-                network.send_packet(&ku, sizeof(KeyboardUpdate));
+        tick_id++;
+
+        packets_this_tick.clear();
+        if (replaying) {
+            for (const capture::Record &record : replay_records) {
+                if (record.type == capture::RecordType::received_packet) {
+                    packets_this_tick.emplace_back(record.data, record.size);
+                }
             }
-            kus_since_last_cts_send.clear();
-        }
-
-        std::vector<GameUpdate> game_updates_this_tick;
-        std::vector<PacketWithSize> packets = network.get_network_events_received_since_last_tick();
-
-        if (packets.size() >= 1) {
-            p("=== ITERATING OVER NEW PACKETS START ===");
-            for (PacketWithSize pws : packets) {
-                GameUpdate game_update;
-                std::memcpy(&game_update, pws.data.data(), sizeof(GameUpdate));
-                game_updates_this_tick.push_back(game_update);
+        } else {
+            received_packets = network.get_network_events_received_since_last_tick();
+            for (const PacketWithSize &packet : received_packets) {
+                packets_this_tick.emplace_back(packet.data.data(), packet.data.size());
+                if (capture_writer) {
+                    capture_writer->write(capture::RecordType::received_packet, packet.data.data(),
+                                          packet.data.size());
+                }
             }
-            p("=== ITERATING OVER NEW PACKETS END ===");
+        }
+        for (std::span<const char> packet : packets_this_tick) {
+            received_packet_bytes.record(packet.size());
         }
 
-        if (game_updates_this_tick.size() >= 1) {
-            p("=== RECEIVED GAME UPDATE AND NOW RECONCILING START ===");
-            GameUpdate last_received_game_update = game_updates_this_tick.back();
-
-            glm::vec2 our_client_position_at_server_id =
-                id_to_position[last_received_game_update.last_id_used_to_produce_this_update];
+        // when the keys behind the input made this tick last changed, only read if one is made
+        double input_changed_at = 0;
+        auto sample_input = [&]() {
+            uint64_t input = 0;
+            if (replaying) {
+                // whether an input is made comes out the same as when it was recorded since it only depends on dt and
+                // what the server sent, only what was held has to come from the capture
+                for (const capture::Record &record : replay_records) {
+                    if (record.type == capture::RecordType::local_input and record.size == sizeof(input)) {
+                        std::memcpy(&input, record.data, sizeof(input));
+                    }
+                }
+            } else {
+                input = published_input.load(std::memory_order_acquire);
+                if (capture_writer) {
+                    capture_writer->write(capture::RecordType::local_input, &input, sizeof(input));
+                }
+            }
+            input_changed_at = (input >> input_timestamp_shift) / 1e6;
+            return KeyboardUpdate{0, 0, static_cast<bool>(input & forward_key_bit),
+                                  static_cast<bool>(input & backwards_key_bit), static_cast<bool>(input & left_key_bit),
+                                  static_cast<bool>(input & right_key_bit)};
+        };
+        // a replay only goes as far as encoding what it would have sent
+        auto send = [&](const wire_format::EncodedMessage &message) {
+            if (not replaying) {
+                network.send_packet(message.data.data(), message.size);
+            }
+            sent_packet_bytes.record(message.size);
+        };
+
+        ClientSimulation::TickResult tick_result =
+            client_simulation.tick(dt, tick_start, sample_input, packets_this_tick, send);
+
+        if (tick_result.made_input.has_value()) {
+            if (input_changed_at > newest_simulated_input_change) {
+                newest_simulated_input_change = input_changed_at;
+                double input_latency = tick_start - input_changed_at;
+                num_input_changes_simulated_since_stats++;
+                total_input_latency_since_stats += input_latency;
+                max_input_latency_since_stats = std::max(max_input_latency_since_stats, input_latency);
+                input_to_simulation_ms.record(1000 * input_latency);
+            }
+            if (last_simulation_step_time.has_value()) {
+                double jitter = std::abs(tick_start - last_simulation_step_time.value() - client_simulation_period);
+                num_simulation_steps_since_stats++;
+                total_simulation_step_jitter_since_stats += jitter;
+                max_simulation_step_jitter_since_stats = std::max(max_simulation_step_jitter_since_stats, jitter);
+                simulation_step_jitter_ms.record(1000 * jitter);
+            }
+            last_simulation_step_time = tick_start;
 
-            std::string result =
-                std::format("our position at id {} was ({}, {}) now setting position to ({}, {})",
-                            last_received_game_update.last_id_used_to_produce_this_update,
-                            our_client_position_at_server_id.x, our_client_position_at_server_id.y,
-                            last_received_game_update.position_x, last_received_game_update.position_y);
-            p(result);
+            client_only_character->SetLinearVelocity(g2j(glm::vec3(client_simulation.get_velocity(), 0)));
+            update_character(physics.physics_system, *client_only_character, client_simulation_period,
+                             temp_allocator);
+            client_only_transform.position = j2g(client_only_character->GetLinearVelocity());
+        }
 
-            JPH::Vec3 server_pos(last_received_game_update.position_x, last_received_game_update.position_y, 0);
-            server_only_character->SetPosition(server_pos);
+        if (tick_result.reconciliation.has_value()) {
+            const ClientSimulation::Reconciliation &reconciliation = tick_result.reconciliation.value();
+            server_only_character->SetPosition(
+                JPH::Vec3(reconciliation.server_position.x, reconciliation.server_position.y, 0));
             server_only_transform.position = j2g(server_only_character->GetPosition());
-            /*server_only_transform.position.x = last_received_game_update.position_x;*/
-            /*server_only_transform.position.y = last_received_game_update.position_y;*/
-
-            result = std::format("predicted position was: ({}, {}) now setting position to ({}, {})",
-                                 transform.position.x, transform.position.y, last_received_game_update.position_x,
-                                 last_received_game_update.position_y);
-            p(result);
-
-            Transform predicted_transform = transform;
-            double predicted_position_x = transform.position.x;
-            double predicted_position_y = transform.position.y;
-            // slam it in
-            cpsr_character->SetPosition(server_pos);
-            transform.position = j2g(cpsr_character->GetPosition());
-            /*transform.position.x = last_received_game_update.position_x;*/
-            /*transform.position.y = last_received_game_update.position_y;*/
-            JPH::Vec3 server_vel(last_received_game_update.velocity_x, last_received_game_update.velocity_y, 0);
-            cpsr_character->SetLinearVelocity(server_vel);
-            // could use the characters vel
-            current_velocity.x = cpsr_character->GetLinearVelocity().GetX();
-            current_velocity.y = cpsr_character->GetLinearVelocity().GetY();
-            // TODO: was about to go put jolt on the server and continue onward.
-            // reconcile
-            client_physics.re_process_after_id(last_received_game_update.last_id_used_to_produce_this_update);
-
-            result = std::format("position before reconciliation was: ({}, {}) after reconciliation was ({}, {})\n"
-                                 "the delta (predicted - reconciled): {}\n"
-                                 "=== RECEIVED GAME UPDATE AND NOW RECONCILING END ===",
-                                 predicted_position_x, predicted_position_y, transform.position.x, transform.position.y,
-                                 glm::length(predicted_transform.position - transform.position));
-            p(result);
+            if (reconciliation.replayed) {
+                num_replays_since_stats++;
+                num_ticks_replayed_since_stats += reconciliation.ticks_after_server_id;
+                replay_time_since_stats += reconciliation.replay_time;
+            } else {
+                num_replays_skipped_since_stats++;
+                num_ticks_not_replayed_since_stats += reconciliation.ticks_after_server_id;
+            }
         }
 
-        curr_id++;
+        if (reconciliation_stats_signal.process_and_get_signal()) {
+            // a skipped replay would have cost about what an average replayed tick costs, per tick it would've redone
+            double time_per_replayed_tick =
+                num_ticks_replayed_since_stats == 0 ? 0 : replay_time_since_stats / num_ticks_replayed_since_stats;
+            spdlog::info("re-simulated {} ticks/s over {} replays taking {:.3f}ms, skipped {} replays saving about "
+                         "{:.3f}ms",
+                         num_ticks_replayed_since_stats, num_replays_since_stats, 1000 * replay_time_since_stats,
+                         num_replays_skipped_since_stats,
+                         1000 * time_per_replayed_tick * num_ticks_not_replayed_since_stats);
+            spdlog::info("sending at {:.0f}bps, {}", network.average_bits_per_second_sent(),
+                         send_unacknowledged_input_window ? "every unacknowledged input in one packet"
+                                                          : "one packet per input");
+            num_replays_since_stats = 0;
+            num_ticks_replayed_since_stats = 0;
+            replay_time_since_stats = 0;
+            num_replays_skipped_since_stats = 0;
+            num_ticks_not_replayed_since_stats = 0;
+
+            double average_input_latency =
+                num_input_changes_simulated_since_stats == 0
+                    ? 0
+                    : total_input_latency_since_stats / num_input_changes_simulated_since_stats;
+            double average_simulation_step_jitter =
+                num_simulation_steps_since_stats == 0
+                    ? 0
+                    : total_simulation_step_jitter_since_stats / num_simulation_steps_since_stats;
+            spdlog::info("{} key changes took {:.3f}ms on average (max {:.3f}ms) to be simulated, {} simulation steps "
+                         "were {:.3f}ms on average (max {:.3f}ms) off from evenly spaced",
+                         num_input_changes_simulated_since_stats, 1000 * average_input_latency,
+                         1000 * max_input_latency_since_stats, num_simulation_steps_since_stats,
+                         1000 * average_simulation_step_jitter, 1000 * max_simulation_step_jitter_since_stats);
+            num_input_changes_simulated_since_stats = 0;
+            total_input_latency_since_stats = 0;
+            max_input_latency_since_stats = 0;
+            num_simulation_steps_since_stats = 0;
+            total_simulation_step_jitter_since_stats = 0;
+            max_simulation_step_jitter_since_stats = 0;
+        }
 
-        std::string result =
-            std::format("=== TICK END ===\nclient sending at: {}bps", network.average_bits_per_second_sent());
-        p(result);
+        Transform rendered_transform;
+        rendered_transform.position = glm::vec3(client_simulation.get_rendered_position(), 0);
 
-        shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR, ShaderUniformVariable::RGBA_COLOR,
-                                 glm::vec4(0, 1, 0, 1));
-        shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR,
-                                 ShaderUniformVariable::LOCAL_TO_WORLD, transform.get_transform_matrix());
-        batcher.cwl_v_transformation_with_solid_color_shader_batcher.queue_draw(0, square_indices, square_vertices);
+        TRACE_TRACE("=== TICK END ===");
 
-        batcher.cwl_v_transformation_with_solid_color_shader_batcher.draw_everything();
+        std::vector<InstancedMeshRenderer::Instance> &square_instances =
+            render_snapshots.get_back_buffer().square_instances;
+        square_instances.clear();
+        square_instances.push_back({rendered_transform.get_transform_matrix(), glm::vec4(0, 1, 0, 1)});
+        square_instances.push_back({server_only_transform.get_transform_matrix(), glm::vec4(1, 0, 0, 1)});
+        square_instances.push_back({client_only_transform.get_transform_matrix(), glm::vec4(0, 0, 1, 1)});
 
-        shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR, ShaderUniformVariable::RGBA_COLOR,
-                                 glm::vec4(1, 0, 0, 1));
-        shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR,
-                                 ShaderUniformVariable::LOCAL_TO_WORLD, server_only_transform.get_transform_matrix());
-        batcher.cwl_v_transformation_with_solid_color_shader_batcher.queue_draw(1, square_indices, square_vertices);
+        client_simulation.sample_remote_characters(get_local_time(), remote_characters);
+        for (const RemoteCharacterInterpolator::RemoteCharacter &remote_character : remote_characters) {
+            Transform remote_transform;
+            remote_transform.position = glm::vec3(remote_character.position, 0);
+            square_instances.push_back({remote_transform.get_transform_matrix(), glm::vec4(1, 1, 0, 1)});
+        }
 
-        batcher.cwl_v_transformation_with_solid_color_shader_batcher.draw_everything();
+        render_snapshots.publish();
+        tick_duration_ms.record(
+            1000 * std::chrono::duration<double>(std::chrono::steady_clock::now() - tick_started_at).count());
+    };
 
-        shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR, ShaderUniformVariable::RGBA_COLOR,
-                                 glm::vec4(0, 0, 1, 1));
-        shader_cache.set_uniform(ShaderType::CWL_V_TRANSFORMATION_WITH_SOLID_COLOR,
-                                 ShaderUniformVariable::LOCAL_TO_WORLD, client_only_transform.get_transform_matrix());
-        batcher.cwl_v_transformation_with_solid_color_shader_batcher.queue_draw(2, square_indices, square_vertices);
+    if (replaying) {
+        // as fast as it will go, the recorded dt and tick times stand in for the clock
+        auto replay_start = std::chrono::steady_clock::now();
+        uint64_t num_ticks_replayed = 0;
+        while (std::optional<capture::TickRecord> tick_record = capture_reader->read_tick(replay_records)) {
+            replay_tick_time = tick_record->time;
+            tick(tick_record->dt);
+            num_ticks_replayed++;
+        }
+        double replay_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+        spdlog::info("replayed {} ticks in {:.3f}s, {:.0f} ticks/s", num_ticks_replayed, replay_time,
+                     num_ticks_replayed / replay_time);
+        metrics::stop_exporting();
+        tracing::stop_tracing();
+        return 0;
+    }
 
-        batcher.cwl_v_transformation_with_solid_color_shader_batcher.draw_everything();
+    // simulation and networking get a thread of their own so a slow swap or a gpu stall never holds up sampling
+    // input or reconciling, and drawing gets one so that waiting on the display never holds up handling events
+    std::thread simulation_thread([&]() {
+        FixedFrequencyLoop ffl;
+        ffl.start(simulation_thread_rate_hz, tick, termination);
+    });
+
+    // a context can only be current on one thread at a time, it's handed back once drawing is done
+    glfwMakeContextCurrent(nullptr);
+    std::thread render_thread([&]() {
+        glfwMakeContextCurrent(window.glfw_window);
+        while (running.load(std::memory_order_acquire)) {
+            render_snapshots.consume();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            square_renderer->draw(render_snapshots.get_front_buffer().square_instances, world_to_clip);
+            glfwSwapBuffers(window.glfw_window);
+        }
+        glfwMakeContextCurrent(nullptr);
+    });
 
+    // glfw only delivers events on the main thread, which now does nothing else, so key changes are published and
+    // timestamped as soon as they arrive
+    while (not glfwWindowShouldClose(window.glfw_window)) {
+        glfwWaitEvents();
         TemporalBinarySignal::process_all();
-        glfwSwapBuffers(window.glfw_window);
-        glfwPollEvents();
-    };
+    }
 
-    FixedFrequencyLoop ffl;
-    ffl.start(512, tick, termination);
+    running.store(false, std::memory_order_release);
+    simulation_thread.join();
+    render_thread.join();
+    // the renderer frees its gl objects when it goes out of scope
+    glfwMakeContextCurrent(window.glfw_window);
 
+    metrics::stop_exporting();
+    tracing::stop_tracing();
     return 0;
 }
@@ -0,0 +1,66 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief hands whole values from one producer thread to one consumer thread without locks or copies, the producer
+ * always has a buffer to write into and the consumer always has the newest finished one to read from, so neither ever
+ * waits on the other
+ *
+ * @note there are three buffers, one owned by each side and one in the middle holding the newest published value,
+ * publishing and consuming just swap an owned buffer with the middle one. Values the consumer never got to are
+ * overwritten, it only ever sees the newest. Buffers are reused rather than cleared, so the producer should reset
+ * whatever it fills in, which also means containers keep their capacity and don't allocate after warming up.
+ */
+template <typename T> class TripleBuffer {
+  public:
+    /**
+     * @brief the buffer to fill in before calling publish, only the producer may touch it
+     */
+    T &get_back_buffer() { return buffers[back_index].value; }
+
+    /**
+     * @brief makes the back buffer the newest value and gives the producer a different one to write into next
+     */
+    void publish() {
+        uint8_t previous_middle = middle.exchange(back_index | newly_published_bit, std::memory_order_acq_rel);
+        back_index = previous_middle & index_mask;
+    }
+
+    /**
+     * @brief swaps the newest published value into the front buffer if there is one we haven't seen yet
+     * @return whether the front buffer changed
+     */
+    bool consume() {
+        if ((middle.load(std::memory_order_relaxed) & newly_published_bit) == 0) {
+            return false;
+        }
+        uint8_t previous_middle = middle.exchange(front_index, std::memory_order_acq_rel);
+        front_index = previous_middle & index_mask;
+        return true;
+    }
+
+    /**
+     * @brief the value from the last successful consume, only the consumer may touch it
+     */
+    const T &get_front_buffer() const { return buffers[front_index].value; }
+
+  private:
+    static constexpr uint8_t index_mask = 0b11;
+    static constexpr uint8_t newly_published_bit = 0b100;
+
+    // each on its own cache line so the two threads writing theirs don't keep stealing it from each other
+    struct alignas(64) Buffer {
+        T value;
+    };
+    std::array<Buffer, 3> buffers;
+
+    uint8_t back_index = 0;
+    alignas(64) uint8_t front_index = 1;
+    alignas(64) std::atomic<uint8_t> middle = 2;
+};
+
+#endif // TRIPLE_BUFFER_HPP
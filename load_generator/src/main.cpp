@@ -0,0 +1,149 @@
+#include "networking/client_networking/network.hpp"
+#include "networking/messages/messages.hpp"
+#include "utility/fixed_frequency_loop/fixed_frequency_loop.hpp"
+#include "utility/periodic_signal/periodic_signal.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+
+/**
+ * @brief a headless stand in for the real client, it only does the networking half: once the server has given it
+ * an id it sends every unacknowledged keyboard update in one packet per tick like the client does, and counts what
+ * comes back
+ */
+struct SimulatedClient {
+    std::unique_ptr<Network> network;
+    std::optional<unsigned int> client_id;
+    int curr_id = 0;
+    KeyboardUpdate held_input;
+    std::vector<KeyboardUpdate> unacknowledged_kus;
+    int last_acknowledged_id = -1;
+    // never decoded, but acknowledging them makes the server delta encode like it would for a real client
+    int newest_world_snapshot_id = -1;
+    std::mt19937 random_engine;
+    uint64_t bytes_received = 0;
+};
+
+int main(int argc, char *argv[]) {
+    if (argc > 4) {
+        std::cout << "usage: " << argv[0] << " [max_clients] [clients_added_per_second] [server_ip]" << std::endl;
+        return 1;
+    }
+
+    unsigned int max_clients = argc > 1 ? std::stoul(argv[1]) : 100;
+    unsigned int clients_added_per_second = argc > 2 ? std::stoul(argv[2]) : 10;
+    std::string server_ip = argc > 3 ? argv[3] : "localhost";
+
+    // one file for everyone, hundreds of colored consoles would bury the report
+    auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("load_generator_network_logs.txt", true);
+    file_sink->set_level(spdlog::level::warn);
+    std::vector<spdlog::sink_ptr> sinks = {file_sink};
+
+    std::vector<SimulatedClient> simulated_clients;
+    simulated_clients.reserve(max_clients);
+
+    auto add_simulated_client = [&]() {
+        SimulatedClient simulated_client;
+        simulated_client.network = std::make_unique<Network>(server_ip, 7777, sinks);
+        simulated_client.network->initialize_network();
+        simulated_client.network->attempt_to_connect_to_server();
+        simulated_client.random_engine.seed(simulated_clients.size());
+        simulated_clients.push_back(std::move(simulated_client));
+    };
+
+    PeriodicSignal add_client_signal(clients_added_per_second);
+    PeriodicSignal report_signal(1);
+    std::bernoulli_distribution change_input(0.05);
+    std::bernoulli_distribution key_pressed(0.5);
+
+    std::function<void(double)> tick = [&](double) {
+        if (simulated_clients.size() < max_clients and add_client_signal.process_and_get_signal()) {
+            add_simulated_client();
+        }
+
+        for (auto &simulated_client : simulated_clients) {
+            for (const PacketWithSize &pws : simulated_client.network->get_network_events_received_since_last_tick()) {
+                simulated_client.bytes_received += pws.data.size();
+                std::optional<wire_format::MessageType> message_type =
+                    wire_format::peek_message_type(pws.data.data(), pws.data.size());
+                if (message_type == wire_format::MessageType::client_id_assignment) {
+                    std::optional<ClientIdAssignment> client_id_assignment =
+                        wire_format::decode_client_id_assignment(pws.data.data(), pws.data.size());
+                    if (client_id_assignment.has_value()) {
+                        simulated_client.client_id = client_id_assignment->client_id;
+                    }
+                } else if (message_type == wire_format::MessageType::game_update) {
+                    std::optional<GameUpdate> game_update =
+                        wire_format::decode_game_update(pws.data.data(), pws.data.size());
+                    if (game_update.has_value()) {
+                        simulated_client.last_acknowledged_id = std::max(
+                            simulated_client.last_acknowledged_id, game_update->last_id_used_to_produce_this_update);
+                    }
+                } else if (message_type == wire_format::MessageType::world_snapshot) {
+                    std::optional<wire_format::WorldSnapshotHeader> header =
+                        wire_format::peek_world_snapshot_header(pws.data.data(), pws.data.size());
+                    if (header.has_value()) {
+                        simulated_client.newest_world_snapshot_id =
+                            std::max(simulated_client.newest_world_snapshot_id, header->id);
+                    }
+                }
+            }
+
+            if (not simulated_client.client_id.has_value()) {
+                continue;
+            }
+
+            // hold keys for a while like a person would instead of mashing every tick
+            if (change_input(simulated_client.random_engine)) {
+                simulated_client.held_input.forward_pressed = key_pressed(simulated_client.random_engine);
+                simulated_client.held_input.backwards_pressed = key_pressed(simulated_client.random_engine);
+                simulated_client.held_input.left_pressed = key_pressed(simulated_client.random_engine);
+                simulated_client.held_input.right_pressed = key_pressed(simulated_client.random_engine);
+            }
+
+            KeyboardUpdate ku = simulated_client.held_input;
+            ku.client_id = simulated_client.client_id.value();
+            ku.id = simulated_client.curr_id++;
+            simulated_client.unacknowledged_kus.push_back(ku);
+
+            std::erase_if(simulated_client.unacknowledged_kus,
+                          [&](const KeyboardUpdate &ku) { return ku.id <= simulated_client.last_acknowledged_id; });
+            if (simulated_client.unacknowledged_kus.size() > wire_format::max_keyboard_updates_per_batch) {
+                simulated_client.unacknowledged_kus.erase(simulated_client.unacknowledged_kus.begin());
+            }
+            wire_format::EncodedMessage encoded_keyboard_update_batch = wire_format::encode_keyboard_update_batch(
+                simulated_client.client_id.value(), simulated_client.unacknowledged_kus,
+                simulated_client.newest_world_snapshot_id);
+            simulated_client.network->send_packet(encoded_keyboard_update_batch.data.data(),
+                                                  encoded_keyboard_update_batch.size);
+        }
+
+        if (report_signal.process_and_get_signal()) {
+            unsigned int connected_clients = 0;
+            uint64_t total_bytes_received = 0;
+            double total_bits_per_second_sent = 0;
+            for (auto &simulated_client : simulated_clients) {
+                connected_clients += simulated_client.client_id.has_value();
+                total_bytes_received += simulated_client.bytes_received;
+                total_bits_per_second_sent += simulated_client.network->average_bits_per_second_sent();
+                simulated_client.bytes_received = 0;
+            }
+            double divisor = simulated_clients.empty() ? 1 : simulated_clients.size();
+            std::cout << std::format("clients: {} connected: {} per client sent: {:.0f}bps received: {:.0f}bps",
+                                     simulated_clients.size(), connected_clients,
+                                     total_bits_per_second_sent / divisor, 8 * total_bytes_received / divisor)
+                      << std::endl;
+        }
+    };
+
+    std::function<bool()> termination = [&]() { return false; };
+    FixedFrequencyLoop ffl;
+    ffl.start(60, tick, termination);
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <Jolt/Jolt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/physics/physics.hpp"
+#include "system_logic/server_simulation/server_simulation.hpp"
+#include "utility/capture/capture.hpp"
+#include "utility/work_stealing_pool/work_stealing_pool.hpp"
+
+namespace {
+
+const double tick_period = 1.0 / 60;
+const float spawn_spacing = 5;
+const unsigned int spawn_grid_width = 32;
+
+struct RecordingTimes {
+    double mean;
+    double max;
+    uint64_t num_bytes;
+};
+
+/**
+ * @brief records what a server with num_clients connected would have received over num_ticks, every client sends the
+ * inputs it hasn't had acknowledged yet about once a tick, sometimes skipping a tick and sometimes sending two at once
+ *
+ * @note the packets are encoded before the tick's recording starts, so only begin_tick and the writes are timed
+ */
+RecordingTimes record(const std::string &path, unsigned int num_clients, unsigned int num_ticks) {
+    std::mt19937_64 random_engine(1);
+    std::bernoulli_distribution change_keys(1.0 / 30);
+    std::uniform_int_distribution<int> held_keys(0, 15);
+    std::uniform_int_distribution<int> one_in_ten(0, 9);
+    std::vector<std::vector<KeyboardUpdate>> unacknowledged_inputs(num_clients);
+    std::vector<int> next_input_ids(num_clients, 0);
+    std::vector<int> keys(num_clients, 0);
+
+    std::vector<std::vector<char>> packets;
+    double total_seconds = 0;
+    double max_seconds = 0;
+    capture::CaptureWriter capture_writer(path);
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        packets.clear();
+        for (unsigned int client_id = 0; client_id < num_clients; client_id++) {
+            if (change_keys(random_engine)) {
+                keys[client_id] = held_keys(random_engine);
+            }
+            int num_inputs_made = one_in_ten(random_engine) == 0 ? 0 : (one_in_ten(random_engine) == 0 ? 2 : 1);
+            // a client that skipped catches up rather than falling further behind
+            if (next_input_ids[client_id] < static_cast<int>(tick) - 2) {
+                num_inputs_made = 2;
+            }
+            std::vector<KeyboardUpdate> &unacknowledged = unacknowledged_inputs[client_id];
+            for (int i = 0; i < num_inputs_made; i++) {
+                int held = keys[client_id];
+                unacknowledged.push_back(KeyboardUpdate(client_id, next_input_ids[client_id]++, held & 1, held & 2,
+                                                        held & 4, held & 8));
+            }
+            // about a 50ms round trip's worth stays unacknowledged
+            if (unacknowledged.size() > 3) {
+                unacknowledged.erase(unacknowledged.begin(), unacknowledged.end() - 3);
+            }
+            if (num_inputs_made == 0) {
+                continue;
+            }
+            wire_format::EncodedMessage message =
+                wire_format::encode_keyboard_update_batch(client_id, unacknowledged, static_cast<int>(tick) - 3);
+            // a received client packet record is the client id followed by the packet
+            uint32_t captured_client_id = client_id;
+            std::vector<char> &packet = packets.emplace_back(sizeof(captured_client_id) + message.size);
+            std::memcpy(packet.data(), &captured_client_id, sizeof(captured_client_id));
+            std::memcpy(packet.data() + sizeof(captured_client_id), message.data.data(), message.size);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        capture_writer.begin_tick(tick, tick_period, tick * tick_period);
+        if (tick == 0) {
+            for (uint32_t client_id = 0; client_id < num_clients; client_id++) {
+                capture_writer.write(capture::RecordType::client_connected, &client_id, sizeof(client_id));
+            }
+        }
+        for (const std::vector<char> &packet : packets) {
+            capture_writer.write(capture::RecordType::received_client_packet, packet.data(), packet.size());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        total_seconds += seconds;
+        max_seconds = std::max(max_seconds, seconds);
+    }
+    return {total_seconds / num_ticks, max_seconds, capture_writer.get_num_bytes_written()};
+}
+
+/**
+ * @brief reads every tick back without doing anything with it, what replaying costs before any simulation
+ * @return ticks per second
+ */
+double read_back(const std::string &path) {
+    capture::CaptureReader capture_reader(path);
+    std::vector<capture::Record> records;
+    uint64_t num_ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (capture_reader.read_tick(records).has_value()) {
+        num_ticks++;
+    }
+    return num_ticks / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief replays the capture through the server simulation as fast as it will go, the way the server's --replay does
+ * @return ticks per second
+ */
+double replay(const std::string &path, unsigned int num_threads) {
+    Physics physics;
+    WorkStealingPool pool(num_threads);
+    ServerSimulation server({tick_period}, physics.physics_system, pool);
+    capture::CaptureReader capture_reader(path);
+    std::vector<capture::Record> records;
+    uint64_t num_ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (std::optional<capture::TickRecord> tick_record = capture_reader.read_tick(records)) {
+        for (const capture::Record &record : records) {
+            uint32_t client_id;
+            std::memcpy(&client_id, record.data, sizeof(client_id));
+            if (record.type == capture::RecordType::client_connected) {
+                physics.create_character(client_id);
+                JPH::Ref<JPH::CharacterVirtual> character = physics.client_id_to_physics_character[client_id];
+                // spread out like in the server tick benchmark, piled on one spawn point everyone would be in
+                // everyone's interest radius and gathering them would swamp the rest of the tick
+                character->SetPosition(JPH::Vec3(spawn_spacing * (client_id % spawn_grid_width),
+                                                 spawn_spacing * (client_id / spawn_grid_width), 0));
+                server.connect_client(client_id, character);
+            } else if (record.type == capture::RecordType::received_client_packet) {
+                server.receive_packet(
+                    client_id, std::span<const char>(record.data + sizeof(client_id), record.size - sizeof(client_id)),
+                    tick_record->time);
+            }
+        }
+        server.tick(static_cast<float>(tick_record->dt), tick_record->time,
+                    [](unsigned int, const wire_format::EncodedMessage &) {});
+        num_ticks++;
+    }
+    return num_ticks / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+/**
+ * @brief what recording costs a server tick and how fast a capture replays, at 10, 100 and 1000 clients, both reading
+ * it back alone and running it through the simulation like --replay
+ *
+ * @note real time is 60 ticks per second, so a replay at 6000 ticks/s goes through a minute of play in 0.6s
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 4) {
+        std::cout << "usage: " << argv[0] << " [num_ticks] [capture_path] [num_threads]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 3600;
+    std::string capture_path = argc > 2 ? argv[2] : "capture_replay_benchmark.cpsrcap";
+    unsigned int num_threads = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << std::format("{} ticks, replaying on {} threads\n", num_ticks, num_threads);
+    for (unsigned int num_clients : {10u, 100u, 1000u}) {
+        RecordingTimes recording_times = record(capture_path, num_clients, num_ticks);
+        double read_ticks_per_second = read_back(capture_path);
+        double replay_ticks_per_second = replay(capture_path, num_threads);
+        std::cout << std::format("{:>4} clients: {:.1f}MB, recording mean {:.2f}us max {:.2f}us per tick, read back "
+                                 "{:.0f} ticks/s, replayed {:.0f} ticks/s, {:.1f}x real time\n",
+                                 num_clients, recording_times.num_bytes / 1e6, 1e6 * recording_times.mean,
+                                 1e6 * recording_times.max, read_ticks_per_second, replay_ticks_per_second,
+                                 replay_ticks_per_second * tick_period);
+    }
+    std::remove(capture_path.c_str());
+    return 0;
+}
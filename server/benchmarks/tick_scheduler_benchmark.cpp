@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "utility/tick_scheduler/tick_scheduler.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const double simulation_period = 1.0 / 60;
+// the rate both binaries used to run their loop at, the simulation only ran every eighth or so iteration
+const double old_loop_period = 1.0 / 512;
+
+struct LoopResult {
+    // cpu time over wall time, 1 is a whole core
+    double cpu_utilization;
+    size_t num_ticks;
+    // how far the time between consecutive ticks strayed from the simulation period
+    double mean_jitter;
+    double p99_jitter;
+    double max_jitter;
+};
+
+/**
+ * @brief stands in for a tick's work, busy rather than sleeping so it shows up as cpu time like the real thing
+ */
+void simulate_clients(unsigned int num_clients, double seconds_per_client) {
+    Clock::time_point end =
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(num_clients * seconds_per_client));
+    while (Clock::now() < end) {
+    }
+}
+
+/**
+ * @brief times a loop which calls tick when it wants the simulation to run and returns once run_loop does
+ */
+template <typename RunLoop> LoopResult measure(RunLoop &&run_loop) {
+    std::vector<double> tick_intervals;
+    std::optional<Clock::time_point> last_tick;
+    auto tick = [&]() {
+        Clock::time_point now = Clock::now();
+        if (last_tick.has_value()) {
+            tick_intervals.push_back(std::chrono::duration<double>(now - last_tick.value()).count());
+        }
+        last_tick = now;
+    };
+
+    std::clock_t cpu_start = std::clock();
+    Clock::time_point wall_start = Clock::now();
+    run_loop(tick);
+    double wall_seconds = std::chrono::duration<double>(Clock::now() - wall_start).count();
+    double cpu_seconds = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    std::vector<double> jitters;
+    double total_jitter = 0;
+    for (double interval : tick_intervals) {
+        jitters.push_back(std::abs(interval - simulation_period));
+        total_jitter += jitters.back();
+    }
+    std::sort(jitters.begin(), jitters.end());
+    return {cpu_seconds / wall_seconds, tick_intervals.size() + 1, total_jitter / jitters.size(),
+            jitters[static_cast<size_t>(0.99 * (jitters.size() - 1))], jitters.back()};
+}
+
+} // namespace
+
+/**
+ * @brief compares cpu use and tick jitter of the timerfd tick scheduler against the loops it replaced, which woke up
+ * at 512 Hz and only ran the simulation once 1/60 of a second had passed since it last did, at 1, 10 and 100 clients
+ *
+ * @note the old FixedFrequencyLoop lives in a toolbox submodule, so both ways it could wait out the rest of an
+ * iteration are measured, sleeping and spinning on the clock
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 3) {
+        std::cout << "usage: " << argv[0] << " [seconds_per_run] [microseconds_per_client]" << std::endl;
+        return 1;
+    }
+    double seconds_per_run = argc > 1 ? std::stod(argv[1]) : 5;
+    double seconds_per_client = (argc > 2 ? std::stod(argv[2]) : 30) / 1e6;
+    auto run_for = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds_per_run));
+
+    for (unsigned int num_clients : {1u, 10u, 100u}) {
+        LoopResult old_sleeping = measure([&](auto &tick) {
+            Clock::time_point start = Clock::now();
+            Clock::time_point last_simulated = start;
+            while (Clock::now() - start < run_for) {
+                Clock::time_point iteration_start = Clock::now();
+                if (std::chrono::duration<double>(iteration_start - last_simulated).count() >= simulation_period) {
+                    last_simulated = iteration_start;
+                    tick();
+                    simulate_clients(num_clients, seconds_per_client);
+                }
+                std::chrono::duration<double> remaining =
+                    std::chrono::duration<double>(old_loop_period) - (Clock::now() - iteration_start);
+                if (remaining.count() > 0) {
+                    std::this_thread::sleep_for(remaining);
+                }
+            }
+        });
+
+        LoopResult old_spinning = measure([&](auto &tick) {
+            Clock::time_point start = Clock::now();
+            Clock::time_point last_simulated = start;
+            Clock::time_point last_iteration = start;
+            while (Clock::now() - start < run_for) {
+                Clock::time_point now = Clock::now();
+                if (std::chrono::duration<double>(now - last_iteration).count() < old_loop_period) {
+                    continue;
+                }
+                last_iteration = now;
+                if (std::chrono::duration<double>(now - last_simulated).count() >= simulation_period) {
+                    last_simulated = now;
+                    tick();
+                    simulate_clients(num_clients, seconds_per_client);
+                }
+            }
+        });
+
+        LoopResult scheduled = measure([&](auto &tick) {
+            Clock::time_point start = Clock::now();
+            TickScheduler tick_scheduler(60);
+            tick_scheduler.start(
+                [&](double) {
+                    tick();
+                    simulate_clients(num_clients, seconds_per_client);
+                },
+                [&]() { return Clock::now() - start >= run_for; });
+        });
+
+        for (auto [name, result] : {std::pair{"512 Hz loop, sleeping", old_sleeping},
+                                    {"512 Hz loop, spinning", old_spinning},
+                                    {"tick scheduler", scheduled}}) {
+            std::cout << std::format("{:>3} clients {:<21} cpu {:>5.1f}% {:.1f} ticks/s, jitter mean {:.3f}ms "
+                                     "p99 {:.3f}ms max {:.3f}ms\n",
+                                     num_clients, name, 100 * result.cpu_utilization,
+                                     result.num_ticks / seconds_per_run, 1000 * result.mean_jitter,
+                                     1000 * result.p99_jitter, 1000 * result.max_jitter);
+        }
+    }
+    return 0;
+}
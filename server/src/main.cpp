@@ -1,56 +1,65 @@
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <cstring>
+#include <span>
 #include "networking/server_networking/network.hpp"
-#include "utility/fixed_frequency_loop/fixed_frequency_loop.hpp"
-#include "utility/fixed_frequency_processor/fixed_frequency_processor.hpp"
-#include "utility/transform/transform.hpp"
+#include "networking/messages/messages.hpp"
+#include "utility/periodic_signal/periodic_signal.hpp"
 #include <format>
 #include <string>
 #include "system_logic/physics/physics.hpp"
-#include "utility/jolt_glm_type_conversions/jolt_glm_type_conversions.hpp"
+#include "system_logic/server_simulation/server_simulation.hpp"
+#include "utility/work_stealing_pool/work_stealing_pool.hpp"
+#include "utility/tracing/tracing.hpp"
+#include "utility/metrics/metrics.hpp"
+#include "utility/tick_scheduler/tick_scheduler.hpp"
+#include "utility/capture/capture.hpp"
 
-struct GameUpdate {
-    double position_x;
-    double position_y;
-    double velocity_x;
-    double velocity_y;
+// the server wakes exactly this often and steps every client once per wake up
+constexpr unsigned int simulation_rate_hz = 60;
 
-    int last_id_used_to_produce_this_update;
-
-    // Overloading the << operator
-    friend std::ostream &operator<<(std::ostream &os, const GameUpdate &update) {
-        os << "GameUpdate { position: " << update.position_x << ", " << update.position_y
-           << ", last_id_used_to_produce_this_update: " << update.last_id_used_to_produce_this_update << " }";
-        return os;
-    }
+/**
+ * @brief a packet being handled this tick and the connection it came in on, which is who it gets attributed to
+ */
+struct ClientPacket {
+    unsigned int client_id;
+    std::span<const char> data;
 };
 
-struct KeyboardUpdate {
-    int id;
-    bool forward_pressed = false;
-    bool backwards_pressed = false;
-    bool left_pressed = false;
-    bool right_pressed = false;
-
-    friend std::ostream &operator<<(std::ostream &os, const KeyboardUpdate &update) {
-        os << "KeyboardUpdate{id: " << update.id << ", forward_pressed: " << update.forward_pressed
-           << ", backwards_pressed: " << update.backwards_pressed << ", left_pressed: " << update.left_pressed
-           << ", right_pressed: " << update.right_pressed << "}";
-        return os;
+int main(int argc, char *argv[]) {
+    std::optional<unsigned int> num_simulation_threads;
+    // --record writes everything that comes in to a capture, --replay runs one back as fast as possible instead of
+    // listening on the network
+    std::optional<std::string> record_path;
+    std::optional<std::string> replay_path;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--record" and i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (argument == "--replay" and i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (not num_simulation_threads.has_value() and not argument.starts_with("-")) {
+            num_simulation_threads = std::stoul(argument);
+        } else {
+            valid_arguments = false;
+        }
     }
-};
-
-constexpr bool printing_active = true;
-void p(std::string s) {
-    if (printing_active) {
-        std::cout << s << std::endl;
+    if (not valid_arguments or (record_path.has_value() and replay_path.has_value())) {
+        std::cout << "usage: " << argv[0] << " [num_simulation_threads] [--record <capture> | --replay <capture>]"
+                  << std::endl;
+        return 1;
     }
-}
-
-int main() {
+    bool replaying = replay_path.has_value();
 
     Physics physics;
-    physics.create_character(0);
-    JPH::Ref<JPH::CharacterVirtual> physics_character = physics.client_id_to_physics_character[0];
+
+    WorkStealingPool simulation_pool(num_simulation_threads.value_or(std::thread::hardware_concurrency()));
+    spdlog::info("simulating characters on {} threads", simulation_pool.get_num_workers());
 
     auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     console_sink->set_level(spdlog::level::debug);
@@ -59,83 +68,205 @@ int main() {
 
     std::vector<spdlog::sink_ptr> sinks = {console_sink, file_sink};
     Network network(7777, sinks);
-    network.initialize_network();
+    if (not replaying) {
+        network.initialize_network();
+    }
+    tracing::start_tracing(sinks);
+    metrics::start_exporting({"server_metrics.csv", "server_metrics.json"});
 
-    int test_client_id = -1;
+    metrics::Histogram &tick_duration_ms = metrics::get_histogram("tick_duration_ms");
+    metrics::Histogram &received_packet_bytes = metrics::get_histogram("received_packet_bytes");
+    metrics::Histogram &sent_packet_bytes = metrics::get_histogram("sent_packet_bytes");
+    metrics::Counter &malformed_packets = metrics::get_counter("malformed_packets");
+
+    std::unique_ptr<capture::CaptureWriter> capture_writer;
+    if (record_path.has_value()) {
+        capture_writer = std::make_unique<capture::CaptureWriter>(record_path.value());
+        spdlog::info("recording everything received to {}", record_path.value());
+    }
+    std::unique_ptr<capture::CaptureReader> capture_reader;
+    if (replaying) {
+        capture_reader = std::make_unique<capture::CaptureReader>(replay_path.value());
+    }
+
+    // the clients in a capture aren't listening, a replay only goes as far as encoding what it would have sent
+    auto reliable_send = [&](unsigned int client_id, const wire_format::EncodedMessage &message) {
+        if (not replaying) {
+            network.reliable_send(client_id, message.data.data(), message.size);
+        }
+        sent_packet_bytes.record(message.size);
+    };
+    auto unreliable_send = [&](unsigned int client_id, const wire_format::EncodedMessage &message) {
+        if (not replaying) {
+            network.unreliable_send(client_id, message.data.data(), message.size);
+        }
+        sent_packet_bytes.record(message.size);
+    };
+
+    // everything about the connected clients and their characters, the same code the simulation harness runs
+    ServerSimulation server_simulation({1.0 / simulation_rate_hz}, physics.physics_system, simulation_pool);
 
     std::function<void(unsigned int)> on_client_connect = [&](unsigned int client_id) {
-        /*physics.create_character(client_id);*/
-        /*connected_character_data[client_id] = {client_id};*/
+        physics.create_character(client_id);
+        wire_format::EncodedMessage client_id_assignment =
+            server_simulation.connect_client(client_id, physics.client_id_to_physics_character[client_id]);
         spdlog::info("just registered a client with id {}", client_id);
-        // TODO no need to broadcast this to everyone, only used once on the connecting client
-        /*network.reliable_send(client_id, &client_id, sizeof(unsigned int));*/
-        test_client_id = client_id;
+        if (capture_writer) {
+            uint32_t captured_client_id = client_id;
+            capture_writer->write(capture::RecordType::client_connected, &captured_client_id,
+                                  sizeof(captured_client_id));
+        }
+        // only the connecting client needs this, they stamp it on every keyboard update they send us
+        reliable_send(client_id, client_id_assignment);
+    };
+
+    // everything about them goes with them, their character included, so a server that sees many clients come and
+    // go holds on to no more than the ones connected right now
+    std::function<void(unsigned int)> on_client_disconnect = [&](unsigned int client_id) {
+        server_simulation.disconnect_client(client_id);
+        physics.delete_character(client_id);
+        spdlog::info("client with id {} disconnected", client_id);
+        if (capture_writer) {
+            uint32_t captured_client_id = client_id;
+            capture_writer->write(capture::RecordType::client_disconnected, &captured_client_id,
+                                  sizeof(captured_client_id));
+        }
     };
 
     network.set_on_connect_callback(on_client_connect);
+    network.set_on_disconnect_callback(on_client_disconnect);
 
-    std::unordered_map<int, KeyboardUpdate> id_to_keyboard_update;
+    TickScheduler tick_scheduler(simulation_rate_hz);
 
-    Transform transform;
-    float acceleration = 10 * 0.01;
-    float friction = 0.99;
-    glm::vec2 current_velocity(0);
+    uint64_t tick_id = 0;
+    // what came in during the tick being replayed and when it started, read from the capture before each tick
+    std::vector<capture::Record> replay_records;
+    double replay_tick_time = 0;
+    // the packets being handled this tick, pointing into either what the network handed us or the capture
+    std::vector<PacketWithSize> received_packets;
+    std::vector<ClientPacket> packets_this_tick;
+    // a received client packet record is the client id followed by the packet, put together here before writing
+    std::vector<char> captured_client_packet;
 
-    std::function<void(int, double)> physics_tick = [&](int id, double dt) {
-        // Retrieve the latest keyboard state for this id
-        auto it = id_to_keyboard_update.find(id);
-        if (it == id_to_keyboard_update.end()) {
-            p(std::format("No input for id: {}", id));
-            return;
-        }
+    PeriodicSignal stats_signal(1);
+    std::clock_t cpu_time_at_last_stats = std::clock();
+    auto wall_time_at_last_stats = std::chrono::steady_clock::now();
+    uint64_t ticks_since_stats = 0;
+    uint64_t bytes_sent_since_stats = 0;
+    double total_tick_time_since_stats = 0;
+    double max_tick_time_since_stats = 0;
 
-        const KeyboardUpdate &input = it->second;
+    std::function<void(double)> tick = [&](double dt) {
+        auto tick_start = std::chrono::steady_clock::now();
+        // everything read this tick counts as arriving now, it's only ever used at tick granularity anyway
+        double now =
+            replaying ? replay_tick_time : std::chrono::duration<double>(tick_start.time_since_epoch()).count();
 
-        glm::vec2 input_vector(static_cast<int>(input.right_pressed) - static_cast<int>(input.left_pressed),
-                               static_cast<int>(input.forward_pressed) - static_cast<int>(input.backwards_pressed));
+        packets_this_tick.clear();
+        if (replaying) {
+            for (const capture::Record &record : replay_records) {
+                if (record.size < sizeof(uint32_t)) {
+                    continue;
+                }
+                uint32_t client_id;
+                std::memcpy(&client_id, record.data, sizeof(client_id));
+                if (record.type == capture::RecordType::client_connected) {
+                    on_client_connect(client_id);
+                } else if (record.type == capture::RecordType::client_disconnected) {
+                    on_client_disconnect(client_id);
+                } else if (record.type == capture::RecordType::received_client_packet) {
+                    packets_this_tick.push_back(
+                        {client_id, {record.data + sizeof(client_id), record.size - sizeof(client_id)}});
+                }
+            }
+        } else {
+            // written before reading the network since clients connecting and disconnecting in there are recorded as
+            // they happen
+            if (capture_writer) {
+                capture_writer->begin_tick(tick_id, dt, now);
+            }
+            received_packets = network.get_network_events_since_last_tick();
+            for (const PacketWithSize &packet : received_packets) {
+                packets_this_tick.push_back({packet.client_id, {packet.data.data(), packet.data.size()}});
+                if (capture_writer) {
+                    uint32_t captured_client_id = packet.client_id;
+                    captured_client_packet.resize(sizeof(captured_client_id) + packet.data.size());
+                    std::memcpy(captured_client_packet.data(), &captured_client_id, sizeof(captured_client_id));
+                    std::memcpy(captured_client_packet.data() + sizeof(captured_client_id), packet.data.data(),
+                                packet.data.size());
+                    capture_writer->write(capture::RecordType::received_client_packet, captured_client_packet.data(),
+                                          captured_client_packet.size());
+                }
+            }
+        }
+        tick_id++;
 
-        p(std::format("Input Vector: ({}, {})", input_vector.x, input_vector.y));
+        for (const ClientPacket &packet : packets_this_tick) {
+            received_packet_bytes.record(packet.data.size());
+            if (not server_simulation.receive_packet(packet.client_id, packet.data, now)) {
+                TRACE_WARN("dropping malformed packet of {} bytes from client: {}", packet.data.size(),
+                           packet.client_id);
+                malformed_packets.add();
+            }
+        }
 
-        glm::vec3 input_vector_3d(input_vector, 0);
+        server_simulation.tick(dt, now,
+                               [&](unsigned int client_id, const wire_format::EncodedMessage &message) {
+                                   unreliable_send(client_id, message);
+                                   bytes_sent_since_stats += message.size;
+                               });
 
-        auto new_velocity =
-            physics_character->GetLinearVelocity() + g2j(input_vector_3d * acceleration * static_cast<float>(dt));
-        new_velocity *= friction;
-        physics_character->SetLinearVelocity(new_velocity);
-        current_velocity = j2g(physics_character->GetLinearVelocity());
-        physics.update_specific_character(dt, physics_character);
-        transform.position = j2g(physics_character->GetPosition());
-        p(std::format("processing id: {} with dt: {} new position: {}", id, dt, transform.get_string_repr()));
-    };
+        double tick_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick_start).count();
+        tick_duration_ms.record(1000 * tick_time);
+        ticks_since_stats++;
+        total_tick_time_since_stats += tick_time;
+        max_tick_time_since_stats = std::max(max_tick_time_since_stats, tick_time);
 
-    FixedFrequencyProcessor physics_engine(60, physics_tick);
-    PeriodicSignal send_signal(60);
+        if (stats_signal.process_and_get_signal()) {
+            size_t num_clients = server_simulation.get_num_clients();
+            double bytes_per_client =
+                num_clients == 0 ? 0 : static_cast<double>(bytes_sent_since_stats) / num_clients;
+            bytes_sent_since_stats = 0;
 
-    std::function<void(double)> tick = [&](double dt) {
-        std::vector<PacketWithSize> received_packets = network.get_network_events_since_last_tick();
-        for (const auto &packet : received_packets) {
-            const KeyboardUpdate *received_keyboard_update =
-                reinterpret_cast<const KeyboardUpdate *>(packet.data.data());
-
-            p(std::format("keyboard update just received: {}", received_keyboard_update->id));
-            physics_engine.add_id(received_keyboard_update->id);
-            id_to_keyboard_update[received_keyboard_update->id] = *received_keyboard_update;
-        }
+            std::clock_t cpu_time = std::clock();
+            auto wall_time = std::chrono::steady_clock::now();
+            double cpu_utilization = static_cast<double>(cpu_time - cpu_time_at_last_stats) / CLOCKS_PER_SEC /
+                                     std::chrono::duration<double>(wall_time - wall_time_at_last_stats).count();
+            cpu_time_at_last_stats = cpu_time;
+            wall_time_at_last_stats = wall_time;
+            TickScheduler::WakeupStats wakeup_stats = tick_scheduler.take_wakeup_stats();
 
-        if (physics_engine.attempt_to_process()) {
-            p("^^^ just processed ^^^");
+            spdlog::info("clients: {} average tick: {:.3f}ms max tick: {:.3f}ms sent per client: {:.0f}bps cpu: "
+                         "{:.1f}% wake up lateness average: {:.3f}ms max: {:.3f}ms dropped ticks: {}",
+                         num_clients, 1000 * total_tick_time_since_stats / ticks_since_stats,
+                         1000 * max_tick_time_since_stats, 8 * bytes_per_client, 100 * cpu_utilization,
+                         1000 * wakeup_stats.total_lateness / std::max<uint64_t>(1, wakeup_stats.num_wakeups),
+                         1000 * wakeup_stats.max_lateness, wakeup_stats.num_dropped_ticks);
+            ticks_since_stats = 0;
+            total_tick_time_since_stats = 0;
+            max_tick_time_since_stats = 0;
         }
+    };
 
-        if (test_client_id != -1) {
-            if (physics_engine.processed_at_least_one_id and send_signal.process_and_get_signal()) {
-                GameUpdate gu(transform.position.x, transform.position.y, current_velocity.x, current_velocity.y,
-                              physics_engine.get_last_processed_id());
-                std::cout << "sending game update: " << gu << std::endl;
-                network.unreliable_send(test_client_id, &gu, sizeof(GameUpdate));
-            }
+    if (replaying) {
+        // as fast as it will go, the recorded dt and arrival times stand in for the clock
+        auto replay_start = std::chrono::steady_clock::now();
+        uint64_t num_ticks_replayed = 0;
+        while (std::optional<capture::TickRecord> tick_record = capture_reader->read_tick(replay_records)) {
+            replay_tick_time = tick_record->time;
+            tick(tick_record->dt);
+            num_ticks_replayed++;
         }
-    };
+        double replay_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+        spdlog::info("replayed {} ticks with {} clients in {:.3f}s, {:.0f} ticks/s", num_ticks_replayed,
+                     server_simulation.get_num_clients(), replay_time, num_ticks_replayed / replay_time);
+        metrics::stop_exporting();
+        tracing::stop_tracing();
+        return 0;
+    }
+
     std::function<bool()> termination = [&]() { return false; };
-    FixedFrequencyLoop ffl;
-    ffl.start(512, tick, termination);
+    // blocks between ticks instead of polling, enet is serviced when we read the network events at the start of
+    // each tick which is as often as the simulation could use them anyway
+    tick_scheduler.start(tick, termination);
 }
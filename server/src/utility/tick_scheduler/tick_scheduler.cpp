@@ -0,0 +1,77 @@
+#include "tick_scheduler.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint64_t nanoseconds_per_second = 1'000'000'000;
+
+uint64_t monotonic_now_ns() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * nanoseconds_per_second + now.tv_nsec;
+}
+} // namespace
+
+TickScheduler::TickScheduler(unsigned int rate_hz, unsigned int max_catch_up_ticks)
+    : rate_hz(std::max(1u, rate_hz)), period(1.0 / this->rate_hz),
+      max_catch_up_ticks(std::max(1u, max_catch_up_ticks)) {
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer_fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "timerfd_create");
+    }
+}
+
+TickScheduler::~TickScheduler() { close(timer_fd); }
+
+void TickScheduler::start(const std::function<void(double)> &tick, const std::function<bool()> &termination) {
+    uint64_t start_ns = monotonic_now_ns();
+    // computed from the tick number every time rather than by adding the period, 1/60s isn't a whole number of
+    // nanoseconds so adding would slowly drift
+    auto deadline_ns = [&](uint64_t tick_number) { return start_ns + tick_number * nanoseconds_per_second / rate_hz; };
+    auto num_deadlines_passed = [&](uint64_t now_ns) { return (now_ns - start_ns) * rate_hz / nanoseconds_per_second; };
+
+    uint64_t next_tick_number = 1;
+    while (not termination()) {
+        uint64_t deadline = deadline_ns(next_tick_number);
+        itimerspec timer_setting{};
+        timer_setting.it_value.tv_sec = deadline / nanoseconds_per_second;
+        timer_setting.it_value.tv_nsec = deadline % nanoseconds_per_second;
+        // without the timer armed the read below would block forever instead of ticking
+        if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &timer_setting, nullptr) == -1) {
+            throw std::system_error(errno, std::generic_category(), "timerfd_settime");
+        }
+
+        // a deadline that has already passed fires straight away, so this only ever blocks when we're early
+        uint64_t num_expirations;
+        while (read(timer_fd, &num_expirations, sizeof(num_expirations)) == -1 and errno == EINTR) {
+        }
+
+        uint64_t now = std::max(monotonic_now_ns(), deadline);
+        double lateness = static_cast<double>(now - deadline) / nanoseconds_per_second;
+        wakeup_stats.num_wakeups++;
+        wakeup_stats.total_lateness += lateness;
+        wakeup_stats.max_lateness = std::max(wakeup_stats.max_lateness, lateness);
+
+        uint64_t last_due_tick_number = std::max(num_deadlines_passed(now), next_tick_number);
+        uint64_t num_due_ticks = last_due_tick_number - next_tick_number + 1;
+        if (num_due_ticks > max_catch_up_ticks) {
+            wakeup_stats.num_dropped_ticks += num_due_ticks - max_catch_up_ticks;
+            num_due_ticks = max_catch_up_ticks;
+        }
+        for (uint64_t i = 0; i < num_due_ticks; i++) {
+            tick(period);
+        }
+        next_tick_number = last_due_tick_number + 1;
+    }
+}
+
+TickScheduler::WakeupStats TickScheduler::take_wakeup_stats() {
+    WakeupStats taken = wakeup_stats;
+    wakeup_stats = WakeupStats();
+    return taken;
+}
@@ -0,0 +1,51 @@
+#ifndef TICK_SCHEDULER_HPP
+#define TICK_SCHEDULER_HPP
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief runs a tick at a fixed rate by blocking on a timerfd until each deadline instead of spinning, deadlines are
+ * absolute multiples of the period from when it started so time spent ticking or waking up late never adds up to drift
+ *
+ * @note when a tick overruns, the deadlines it missed are run back to back to catch up, but never more than
+ * max_catch_up_ticks at once, past that they are dropped so a long stall doesn't turn into a burst of ticks
+ */
+class TickScheduler {
+  public:
+    explicit TickScheduler(unsigned int rate_hz, unsigned int max_catch_up_ticks = 5);
+    ~TickScheduler();
+
+    TickScheduler(const TickScheduler &) = delete;
+    TickScheduler &operator=(const TickScheduler &) = delete;
+
+    /**
+     * @brief calls tick with the fixed period as dt once per deadline until termination returns true, throws
+     * std::system_error if the timer can't be armed
+     */
+    void start(const std::function<void(double)> &tick, const std::function<bool()> &termination);
+
+    double get_period() const { return period; }
+
+    /**
+     * @brief how late we woke up relative to the deadlines, in seconds, accumulated since the last call to
+     * take_wakeup_stats
+     */
+    struct WakeupStats {
+        uint64_t num_wakeups = 0;
+        uint64_t num_dropped_ticks = 0;
+        double total_lateness = 0;
+        double max_lateness = 0;
+    };
+
+    WakeupStats take_wakeup_stats();
+
+  private:
+    unsigned int rate_hz;
+    double period;
+    unsigned int max_catch_up_ticks;
+    int timer_fd = -1;
+    WakeupStats wakeup_stats;
+};
+
+#endif // TICK_SCHEDULER_HPP
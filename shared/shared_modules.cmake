@@ -0,0 +1,17 @@
+# modules that aren't tied to one program live once under shared/src instead of being copied into each project that
+# uses them, a project includes this file and pulls in the ones it uses with
+#   add_shared_modules(${PROJECT_NAME} networking/messages utility/tracing)
+# which compiles their sources into the target, so they get its compile definitions, and lets it include them from the
+# top of shared/src, as in #include "networking/messages/messages.hpp"
+set(SHARED_MODULES_DIR ${CMAKE_CURRENT_LIST_DIR}/src)
+
+function(add_shared_modules target)
+    foreach(module ${ARGN})
+        if(NOT IS_DIRECTORY ${SHARED_MODULES_DIR}/${module})
+            message(FATAL_ERROR "there is no shared module ${module}")
+        endif()
+        file(GLOB module_sources "${SHARED_MODULES_DIR}/${module}/*.cpp")
+        target_sources(${target} PRIVATE ${module_sources})
+    endforeach()
+    target_include_directories(${target} PRIVATE ${SHARED_MODULES_DIR})
+endfunction()
@@ -0,0 +1,156 @@
+#include "input_jitter_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// recomputing after every arrival would only chase noise, this is often enough to follow a change in a few ticks
+constexpr size_t arrivals_per_target_update = 8;
+
+InputJitterBuffer::InputJitterBuffer(const Settings &settings)
+    : settings(settings), target_depth(settings.min_target_depth) {
+    sorted_arrival_offsets.reserve(num_arrival_offsets);
+}
+
+void InputJitterBuffer::receive(const KeyboardUpdate &keyboard_update, double arrival_time) {
+    // clients resend everything unacknowledged, only the first time an id shows up says anything about its timing
+    if (not newest_received_id.has_value() or keyboard_update.id > newest_received_id.value()) {
+        // next_id ran ahead guessing while the client wasn't sending, everything they send from now on would be
+        // thrown away as too late until their ids caught up
+        if (next_id.has_value() and
+            keyboard_update.id + static_cast<int>(settings.resync_distance) <= next_id.value()) {
+            resync(keyboard_update.id);
+        }
+        newest_received_id = keyboard_update.id;
+        arrival_ids[num_arrival_offsets_recorded % num_arrival_offsets] = keyboard_update.id;
+        arrival_offsets[num_arrival_offsets_recorded % num_arrival_offsets] =
+            arrival_time - keyboard_update.id * settings.tick_period;
+        num_arrival_offsets_recorded++;
+        if (num_arrival_offsets_recorded % arrivals_per_target_update == 0) {
+            update_target_depth();
+        }
+    }
+
+    // too late, its tick was already simulated with a guess
+    if (last_consumed_id.has_value() and keyboard_update.id <= last_consumed_id.value()) {
+        return;
+    }
+    if (keyboard_updates.contains(keyboard_update.id)) {
+        return;
+    }
+    keyboard_updates.insert(keyboard_update.id, keyboard_update);
+    if (not next_id.has_value()) {
+        next_id = keyboard_update.id;
+        last_consumed_input.client_id = keyboard_update.client_id;
+    }
+}
+
+std::optional<KeyboardUpdate> InputJitterBuffer::consume() {
+    if (not next_id.has_value()) {
+        return std::nullopt;
+    }
+
+    unsigned int depth = get_depth();
+    if (depth > target_depth + settings.max_excess_depth) {
+        int skip_to_id = newest_received_id.value() - static_cast<int>(target_depth) + 1;
+        num_skipped += skip_to_id - next_id.value();
+        keyboard_updates.discard_up_to_and_including(skip_to_id - 1);
+        next_id = skip_to_id;
+        depth = get_depth();
+        smoothed_depth = depth;
+    }
+    smoothed_depth += settings.lead_smoothing * (depth - smoothed_depth);
+
+    KeyboardUpdate input;
+    const KeyboardUpdate *received_input = keyboard_updates.find(next_id.value());
+    if (received_input != nullptr) {
+        input = *received_input;
+        num_consecutive_underruns = 0;
+    } else {
+        // they've stopped sending, stay on this id so their input picks up where it left off when it comes back
+        if (num_consecutive_underruns >= settings.max_consecutive_underruns) {
+            return std::nullopt;
+        }
+        input = last_consumed_input;
+        input.id = next_id.value();
+        num_underruns++;
+        num_consecutive_underruns++;
+    }
+    keyboard_updates.discard_up_to_and_including(next_id.value());
+
+    last_consumed_id = next_id;
+    last_consumed_input = input;
+    next_id = next_id.value() + 1;
+    return input;
+}
+
+void InputJitterBuffer::drain(std::vector<KeyboardUpdate> &inputs) {
+    inputs.clear();
+    if (not next_id.has_value()) {
+        return;
+    }
+    for (int id = next_id.value(); id <= newest_received_id.value(); id++) {
+        const KeyboardUpdate *received_input = keyboard_updates.find(id);
+        if (received_input != nullptr) {
+            inputs.push_back(*received_input);
+        }
+    }
+    if (inputs.empty()) {
+        return;
+    }
+    keyboard_updates.discard_up_to_and_including(inputs.back().id);
+    last_consumed_id = inputs.back().id;
+    last_consumed_input = inputs.back();
+    next_id = inputs.back().id + 1;
+}
+
+void InputJitterBuffer::resync(int id) {
+    num_resyncs++;
+    keyboard_updates.clear();
+    next_id = id;
+    last_consumed_id = id - 1;
+    num_consecutive_underruns = 0;
+    // the offsets from before are relative to ids that no longer line up with when input is sent
+    num_arrival_offsets_recorded = 0;
+}
+
+unsigned int InputJitterBuffer::get_depth() const {
+    if (not next_id.has_value() or not newest_received_id.has_value()) {
+        return 0;
+    }
+    return static_cast<unsigned int>(std::max(0, newest_received_id.value() - next_id.value() + 1));
+}
+
+void InputJitterBuffer::update_target_depth() {
+    size_t num_offsets = std::min(num_arrival_offsets_recorded, num_arrival_offsets);
+
+    // the client deliberately speeds up and slows down the rate it makes input at to follow its lead, which shows up
+    // as the offsets drifting over the window, fit a line through them so only the scatter around it counts as jitter
+    double mean_id = 0;
+    double mean_offset = 0;
+    for (size_t i = 0; i < num_offsets; i++) {
+        mean_id += arrival_ids[i];
+        mean_offset += arrival_offsets[i];
+    }
+    mean_id /= num_offsets;
+    mean_offset /= num_offsets;
+    double id_variance = 0;
+    double covariance = 0;
+    for (size_t i = 0; i < num_offsets; i++) {
+        id_variance += (arrival_ids[i] - mean_id) * (arrival_ids[i] - mean_id);
+        covariance += (arrival_ids[i] - mean_id) * (arrival_offsets[i] - mean_offset);
+    }
+    double drift_per_id = id_variance > 0 ? covariance / id_variance : 0;
+
+    sorted_arrival_offsets.clear();
+    for (size_t i = 0; i < num_offsets; i++) {
+        sorted_arrival_offsets.push_back(arrival_offsets[i] - drift_per_id * (arrival_ids[i] - mean_id));
+    }
+    std::sort(sorted_arrival_offsets.begin(), sorted_arrival_offsets.end());
+
+    // the earliest arrival is as good as the network gets, everything later than it has to be waited for
+    double spread = sorted_arrival_offsets[static_cast<size_t>(settings.covered_arrival_fraction * (num_offsets - 1))] -
+                    sorted_arrival_offsets.front();
+    // plus one since even perfectly regular input has to arrive before the tick that uses it
+    unsigned int wanted_depth = static_cast<unsigned int>(std::ceil(spread / settings.tick_period)) + 1;
+    target_depth = std::clamp(wanted_depth, settings.min_target_depth, settings.max_target_depth);
+}
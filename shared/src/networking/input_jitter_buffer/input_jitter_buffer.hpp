@@ -0,0 +1,109 @@
+#ifndef INPUT_JITTER_BUFFER_HPP
+#define INPUT_JITTER_BUFFER_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "../messages/messages.hpp"
+#include "../../utility/tick_ring_buffer/tick_ring_buffer.hpp"
+
+/**
+ * @brief holds on to one client's input so that exactly one input is simulated every tick no matter how bunched up
+ * the packets carrying them arrive
+ *
+ * @note how much to hold back comes from how spread out input has been arriving lately: enough that an input which
+ * arrives as late as most recent ones still makes it in time. If the next input still hasn't arrived when it's needed
+ * the previous one is repeated in its place, most of the time the player is holding the same keys anyway, and the real
+ * one is thrown away when it turns up. How far the buffer is from where it wants to be is sent back to the client as
+ * its lead so it can speed up or slow down the rate it makes input at to get there, the buffer itself only ever skips
+ * ahead when it is hopelessly far behind.
+ *
+ * A client that stops sending altogether isn't guessed for forever, after max_consecutive_underruns the buffer stops
+ * handing out input and waits on the next id. If their input then turns up far behind it, as it does when the client
+ * itself stalled, the buffer starts over from what arrived rather than throwing all of it away as too late.
+ */
+class InputJitterBuffer {
+  public:
+    struct Settings {
+        // how often consume is called, one input id is expected per tick
+        double tick_period = 1.0 / 60;
+        unsigned int min_target_depth = 1;
+        unsigned int max_target_depth = 16;
+        // the depth is chosen so inputs arriving this late relative to the others still make it
+        double covered_arrival_fraction = 0.95;
+        // holding more than this many ticks past the target means the client got way ahead, skip to the newest
+        unsigned int max_excess_depth = 16;
+        // how quickly the reported lead follows the depth, it jumps up every time a packet arrives and down every tick
+        double lead_smoothing = 0.1;
+        // half a second of guessing in a row means the client isn't sending anymore, stop until they do
+        unsigned int max_consecutive_underruns = 30;
+        // a new input at least this many ids behind the next one to consume isn't just late, start over from it
+        unsigned int resync_distance = 8;
+    };
+
+    InputJitterBuffer() : InputJitterBuffer(Settings{}) {}
+    explicit InputJitterBuffer(const Settings &settings);
+
+    /**
+     * @param arrival_time when the packet carrying it was read, in seconds on any clock as long as it's always the same
+     * one
+     */
+    void receive(const KeyboardUpdate &keyboard_update, double arrival_time);
+
+    /**
+     * @brief takes the input for the next id, or the previous input again under the next id if it hasn't arrived
+     * @return nothing until the first input arrives or once it has been guessed max_consecutive_underruns times in a
+     * row, until the next id arrives, otherwise exactly one input per call
+     */
+    std::optional<KeyboardUpdate> consume();
+
+    /**
+     * @brief takes every input received since the last one taken in id order instead, skipping ids that never
+     * arrived, for comparing against not buffering at all, the lead means nothing once this is used
+     */
+    void drain(std::vector<KeyboardUpdate> &inputs);
+
+    /**
+     * @brief how many ticks more input is buffered than the target, positive means the client's input is arriving
+     * earlier than it has to and adds latency, negative means it's arriving too late and being guessed
+     */
+    double get_lead() const { return smoothed_depth - target_depth; }
+
+    std::optional<int> get_last_consumed_id() const { return last_consumed_id; }
+    unsigned int get_target_depth() const { return target_depth; }
+    // the ids from the next one to consume up to the newest one received
+    unsigned int get_depth() const;
+
+    uint64_t get_num_underruns() const { return num_underruns; }
+    uint64_t get_num_skipped() const { return num_skipped; }
+    uint64_t get_num_resyncs() const { return num_resyncs; }
+
+  private:
+    void update_target_depth();
+    void resync(int id);
+
+    Settings settings;
+    TickRingBuffer<KeyboardUpdate, 256> keyboard_updates;
+    std::optional<int> next_id;
+    std::optional<int> newest_received_id;
+    std::optional<int> last_consumed_id;
+    KeyboardUpdate last_consumed_input{};
+
+    // when each recently received input arrived relative to when it would have if they came exactly once a tick
+    static constexpr size_t num_arrival_offsets = 64;
+    std::array<int, num_arrival_offsets> arrival_ids{};
+    std::array<double, num_arrival_offsets> arrival_offsets{};
+    size_t num_arrival_offsets_recorded = 0;
+    std::vector<double> sorted_arrival_offsets;
+
+    unsigned int target_depth;
+    double smoothed_depth = 0;
+    uint64_t num_underruns = 0;
+    unsigned int num_consecutive_underruns = 0;
+    uint64_t num_skipped = 0;
+    uint64_t num_resyncs = 0;
+};
+
+#endif // INPUT_JITTER_BUFFER_HPP
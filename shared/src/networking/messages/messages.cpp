@@ -0,0 +1,522 @@
+#include "messages.hpp"
+
+#include <climits>
+#include <cmath>
+#include <span>
+
+namespace wire_format {
+
+namespace {
+
+class ByteWriter {
+  public:
+    explicit ByteWriter(EncodedMessage &message) : message(message) { message.size = 0; }
+
+    void write_byte(uint8_t byte) { message.data[message.size++] = static_cast<char>(byte); }
+
+    // LEB128, seven bits per byte with the high bit saying whether more follow
+    void write_varint(uint64_t value) {
+        while (value >= 0x80) {
+            write_byte(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        write_byte(static_cast<uint8_t>(value));
+    }
+
+    // zigzag first so small negative numbers stay small
+    void write_signed_varint(int64_t value) {
+        write_varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void write_fixed_point(double value) {
+        // llround has no answer for these, a broken simulation shouldn't also produce undecodable packets
+        if (not std::isfinite(value)) {
+            value = 0;
+        }
+        write_signed_varint(std::llround(value * fixed_point_scale));
+    }
+
+  private:
+    EncodedMessage &message;
+};
+
+class ByteReader {
+  public:
+    explicit ByteReader(std::span<const char> bytes) : bytes(bytes) {}
+
+    bool read_byte(uint8_t &byte) {
+        if (position >= bytes.size()) {
+            return false;
+        }
+        byte = static_cast<uint8_t>(bytes[position++]);
+        return true;
+    }
+
+    bool read_varint(uint64_t &value) {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte;
+            if (not read_byte(byte)) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool read_signed_varint(int64_t &value) {
+        uint64_t zigzagged;
+        if (not read_varint(zigzagged)) {
+            return false;
+        }
+        value = static_cast<int64_t>(zigzagged >> 1) ^ -static_cast<int64_t>(zigzagged & 1);
+        return true;
+    }
+
+    bool read_fixed_point(double &value) {
+        int64_t steps;
+        if (not read_signed_varint(steps)) {
+            return false;
+        }
+        value = static_cast<double>(steps) / fixed_point_scale;
+        return true;
+    }
+
+    bool read_uint32(uint32_t &value) {
+        uint64_t wide;
+        if (not read_varint(wide) or wide > UINT32_MAX) {
+            return false;
+        }
+        value = static_cast<uint32_t>(wide);
+        return true;
+    }
+
+    bool read_header(MessageType expected_type) {
+        std::optional<MessageType> type = peek_message_type(bytes.data(), bytes.size());
+        position = 1;
+        return type == expected_type;
+    }
+
+    bool fully_consumed() const { return position == bytes.size(); }
+
+  private:
+    std::span<const char> bytes;
+    size_t position = 0;
+};
+
+uint8_t make_header(MessageType type) { return static_cast<uint8_t>(version << 4) | static_cast<uint8_t>(type); }
+
+enum CharacterFieldBits : uint8_t {
+    position_x_bit = 1 << 0,
+    position_y_bit = 1 << 1,
+    velocity_x_bit = 1 << 2,
+    velocity_y_bit = 1 << 3,
+    all_character_field_bits = position_x_bit | position_y_bit | velocity_x_bit | velocity_y_bit,
+    // the character was in the baseline but isn't anymore, no fields follow
+    removed_bit = 1 << 4,
+};
+
+// the baseline is written as how far back it is, 0 meaning there is none since nothing is relative to itself
+bool read_world_snapshot_header(ByteReader &reader, WorldSnapshotHeader &header) {
+    uint32_t id;
+    uint32_t baseline_distance;
+    if (not reader.read_header(MessageType::world_snapshot) or not reader.read_uint32(id) or id > INT_MAX or
+        not reader.read_uint32(baseline_distance) or baseline_distance > id) {
+        return false;
+    }
+    header.id = static_cast<int>(id);
+    header.baseline_id = std::nullopt;
+    if (baseline_distance != 0) {
+        header.baseline_id = static_cast<int>(id - baseline_distance);
+    }
+    return true;
+}
+
+enum KeyBits : uint8_t {
+    forward_bit = 1 << 0,
+    backwards_bit = 1 << 1,
+    left_bit = 1 << 2,
+    right_bit = 1 << 3,
+    all_key_bits = forward_bit | backwards_bit | left_bit | right_bit,
+};
+
+uint8_t pack_keys(const KeyboardUpdate &keyboard_update) {
+    return (keyboard_update.forward_pressed ? forward_bit : 0) |
+           (keyboard_update.backwards_pressed ? backwards_bit : 0) | (keyboard_update.left_pressed ? left_bit : 0) |
+           (keyboard_update.right_pressed ? right_bit : 0);
+}
+
+void unpack_keys(uint8_t keys, KeyboardUpdate &keyboard_update) {
+    keyboard_update.forward_pressed = keys & forward_bit;
+    keyboard_update.backwards_pressed = keys & backwards_bit;
+    keyboard_update.left_pressed = keys & left_bit;
+    keyboard_update.right_pressed = keys & right_bit;
+}
+
+} // namespace
+
+int32_t to_fixed_point(double value) {
+    if (not std::isfinite(value)) {
+        return 0;
+    }
+    return static_cast<int32_t>(std::clamp<double>(std::round(value * fixed_point_scale), INT32_MIN, INT32_MAX));
+}
+
+double from_fixed_point(int32_t steps) { return static_cast<double>(steps) / fixed_point_scale; }
+
+EncodedMessage encode(const ClientIdAssignment &client_id_assignment) {
+    EncodedMessage message;
+    ByteWriter writer(message);
+    writer.write_byte(make_header(MessageType::client_id_assignment));
+    writer.write_varint(client_id_assignment.client_id);
+    return message;
+}
+
+EncodedMessage encode(const KeyboardUpdate &keyboard_update) {
+    EncodedMessage message;
+    ByteWriter writer(message);
+    writer.write_byte(make_header(MessageType::keyboard_update));
+    writer.write_varint(keyboard_update.client_id);
+    writer.write_varint(static_cast<uint32_t>(keyboard_update.id));
+    writer.write_byte(pack_keys(keyboard_update));
+    return message;
+}
+
+EncodedMessage encode(const GameUpdate &game_update) {
+    EncodedMessage message;
+    ByteWriter writer(message);
+    writer.write_byte(make_header(MessageType::game_update));
+    writer.write_varint(static_cast<uint32_t>(game_update.last_id_used_to_produce_this_update));
+    writer.write_fixed_point(game_update.position_x);
+    writer.write_fixed_point(game_update.position_y);
+    writer.write_fixed_point(game_update.velocity_x);
+    writer.write_fixed_point(game_update.velocity_y);
+    writer.write_fixed_point(game_update.input_lead);
+    return message;
+}
+
+EncodedMessage encode_keyboard_update_batch(unsigned int client_id, std::span<const KeyboardUpdate> keyboard_updates,
+                                            int acknowledged_world_snapshot_id) {
+    if (keyboard_updates.size() > max_keyboard_updates_per_batch) {
+        keyboard_updates = keyboard_updates.last(max_keyboard_updates_per_batch);
+    }
+
+    EncodedMessage message;
+    ByteWriter writer(message);
+    writer.write_byte(make_header(MessageType::keyboard_update_batch));
+    writer.write_varint(client_id);
+    // shifted by one so that having none is a single zero byte
+    writer.write_varint(static_cast<uint64_t>(static_cast<int64_t>(std::max(-1, acknowledged_world_snapshot_id)) + 1));
+    writer.write_varint(keyboard_updates.size());
+    if (keyboard_updates.empty()) {
+        return message;
+    }
+    writer.write_varint(static_cast<uint32_t>(keyboard_updates.front().id));
+
+    uint8_t previous_keys = pack_keys(keyboard_updates.front());
+    writer.write_byte(previous_keys);
+    size_t repeats = 0;
+    for (const KeyboardUpdate &keyboard_update : keyboard_updates.subspan(1)) {
+        uint8_t keys = pack_keys(keyboard_update);
+        if (keys == previous_keys) {
+            repeats++;
+            continue;
+        }
+        writer.write_varint(repeats);
+        writer.write_byte(keys ^ previous_keys);
+        previous_keys = keys;
+        repeats = 0;
+    }
+    // the decoder knows the count, so a trailing run only needs its length
+    if (repeats > 0) {
+        writer.write_varint(repeats);
+    }
+    return message;
+}
+
+EncodedMessage encode_world_snapshot(const WorldSnapshot &world_snapshot, const WorldSnapshot *baseline) {
+    std::span<const CharacterSnapshot> characters = world_snapshot.characters;
+    std::span<const CharacterSnapshot> baseline_characters;
+    if (baseline) {
+        baseline_characters = baseline->characters;
+    }
+    characters = characters.first(std::min(characters.size(), max_characters_per_snapshot));
+    baseline_characters = baseline_characters.first(std::min(baseline_characters.size(), max_characters_per_snapshot));
+
+    EncodedMessage message;
+    ByteWriter writer(message);
+    writer.write_byte(make_header(MessageType::world_snapshot));
+    writer.write_varint(static_cast<uint32_t>(world_snapshot.id));
+    writer.write_varint(baseline ? static_cast<uint32_t>(world_snapshot.id - baseline->id) : 0);
+
+    // client ids are written as the distance from the previous entry's, the decoder reads entries until the end
+    unsigned int previous_client_id = 0;
+    auto write_entry_header = [&](unsigned int client_id, uint8_t fields) {
+        writer.write_varint(client_id - previous_client_id);
+        writer.write_byte(fields);
+        previous_client_id = client_id;
+    };
+
+    // both lists are sorted by client id, so walking them together pairs every character with its baseline
+    size_t baseline_index = 0;
+    for (const CharacterSnapshot &character : characters) {
+        while (baseline_index < baseline_characters.size() and
+               baseline_characters[baseline_index].client_id < character.client_id) {
+            write_entry_header(baseline_characters[baseline_index++].client_id, removed_bit);
+        }
+
+        // a character the receiver hasn't seen yet is sent relative to all zeroes which is the same as in full
+        CharacterSnapshot reference{character.client_id, 0, 0, 0, 0};
+        bool in_baseline = baseline_index < baseline_characters.size() and
+                           baseline_characters[baseline_index].client_id == character.client_id;
+        if (in_baseline) {
+            reference = baseline_characters[baseline_index++];
+            if (character == reference) {
+                continue;
+            }
+        }
+
+        uint8_t fields = (character.position_x != reference.position_x ? position_x_bit : 0) |
+                         (character.position_y != reference.position_y ? position_y_bit : 0) |
+                         (character.velocity_x != reference.velocity_x ? velocity_x_bit : 0) |
+                         (character.velocity_y != reference.velocity_y ? velocity_y_bit : 0);
+        write_entry_header(character.client_id, fields);
+        if (fields & position_x_bit) {
+            writer.write_signed_varint(static_cast<int64_t>(character.position_x) - reference.position_x);
+        }
+        if (fields & position_y_bit) {
+            writer.write_signed_varint(static_cast<int64_t>(character.position_y) - reference.position_y);
+        }
+        if (fields & velocity_x_bit) {
+            writer.write_signed_varint(static_cast<int64_t>(character.velocity_x) - reference.velocity_x);
+        }
+        if (fields & velocity_y_bit) {
+            writer.write_signed_varint(static_cast<int64_t>(character.velocity_y) - reference.velocity_y);
+        }
+    }
+    while (baseline_index < baseline_characters.size()) {
+        write_entry_header(baseline_characters[baseline_index++].client_id, removed_bit);
+    }
+    return message;
+}
+
+std::optional<MessageType> peek_message_type(const void *data, size_t size) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    if (bytes.empty()) {
+        return std::nullopt;
+    }
+    uint8_t header = static_cast<uint8_t>(bytes[0]);
+    if ((header >> 4) != version) {
+        return std::nullopt;
+    }
+    uint8_t type = header & 0x0f;
+    if (type > static_cast<uint8_t>(MessageType::world_snapshot)) {
+        return std::nullopt;
+    }
+    return static_cast<MessageType>(type);
+}
+
+std::optional<ClientIdAssignment> decode_client_id_assignment(const void *data, size_t size) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    ByteReader reader(bytes);
+    ClientIdAssignment client_id_assignment;
+    if (not reader.read_header(MessageType::client_id_assignment) or
+        not reader.read_uint32(client_id_assignment.client_id) or not reader.fully_consumed()) {
+        return std::nullopt;
+    }
+    return client_id_assignment;
+}
+
+std::optional<KeyboardUpdate> decode_keyboard_update(const void *data, size_t size) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    ByteReader reader(bytes);
+    KeyboardUpdate keyboard_update;
+    uint32_t id;
+    uint8_t keys;
+    if (not reader.read_header(MessageType::keyboard_update) or not reader.read_uint32(keyboard_update.client_id) or
+        not reader.read_uint32(id) or id > INT_MAX or not reader.read_byte(keys) or not reader.fully_consumed()) {
+        return std::nullopt;
+    }
+    if (keys & ~all_key_bits) {
+        return std::nullopt;
+    }
+    keyboard_update.id = static_cast<int>(id);
+    unpack_keys(keys, keyboard_update);
+    return keyboard_update;
+}
+
+std::optional<GameUpdate> decode_game_update(const void *data, size_t size) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    ByteReader reader(bytes);
+    GameUpdate game_update;
+    uint32_t last_id;
+    if (not reader.read_header(MessageType::game_update) or not reader.read_uint32(last_id) or
+        not reader.read_fixed_point(game_update.position_x) or not reader.read_fixed_point(game_update.position_y) or
+        not reader.read_fixed_point(game_update.velocity_x) or not reader.read_fixed_point(game_update.velocity_y) or
+        not reader.read_fixed_point(game_update.input_lead) or not reader.fully_consumed()) {
+        return std::nullopt;
+    }
+    game_update.last_id_used_to_produce_this_update = static_cast<int>(last_id);
+    return game_update;
+}
+
+std::optional<WorldSnapshotHeader> peek_world_snapshot_header(const void *data, size_t size) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    ByteReader reader(bytes);
+    WorldSnapshotHeader header;
+    if (not read_world_snapshot_header(reader, header)) {
+        return std::nullopt;
+    }
+    return header;
+}
+
+bool decode_world_snapshot(const void *data, size_t size, const WorldSnapshot *baseline,
+                           WorldSnapshot &world_snapshot) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    ByteReader reader(bytes);
+    WorldSnapshotHeader header;
+    if (not read_world_snapshot_header(reader, header) or header.baseline_id.has_value() != (baseline != nullptr) or
+        (baseline and baseline->id != header.baseline_id.value())) {
+        return false;
+    }
+    world_snapshot.id = header.id;
+    world_snapshot.characters.clear();
+
+    std::span<const CharacterSnapshot> baseline_characters;
+    if (baseline) {
+        baseline_characters = baseline->characters;
+    }
+    size_t baseline_index = 0;
+
+    auto read_field = [&](uint8_t fields, uint8_t field_bit, int32_t &value) {
+        if ((fields & field_bit) == 0) {
+            return true;
+        }
+        int64_t difference;
+        if (not reader.read_signed_varint(difference)) {
+            return false;
+        }
+        int64_t new_value = value + difference;
+        if (new_value < INT32_MIN or new_value > INT32_MAX) {
+            return false;
+        }
+        value = static_cast<int32_t>(new_value);
+        return true;
+    };
+
+    uint64_t client_id = 0;
+    bool first_entry = true;
+    while (not reader.fully_consumed()) {
+        uint64_t client_id_distance;
+        uint8_t fields;
+        if (not reader.read_varint(client_id_distance) or not reader.read_byte(fields) or
+            fields & ~(all_character_field_bits | removed_bit) or (client_id_distance == 0 and not first_entry)) {
+            return false;
+        }
+        client_id += client_id_distance;
+        first_entry = false;
+        if (client_id > UINT32_MAX) {
+            return false;
+        }
+
+        // anything in the baseline that comes before this entry didn't change
+        while (baseline_index < baseline_characters.size() and
+               baseline_characters[baseline_index].client_id < client_id) {
+            world_snapshot.characters.push_back(baseline_characters[baseline_index++]);
+        }
+        bool in_baseline = baseline_index < baseline_characters.size() and
+                           baseline_characters[baseline_index].client_id == client_id;
+
+        if (fields & removed_bit) {
+            if (not in_baseline or fields != removed_bit) {
+                return false;
+            }
+            baseline_index++;
+            continue;
+        }
+
+        CharacterSnapshot character{static_cast<unsigned int>(client_id), 0, 0, 0, 0};
+        if (in_baseline) {
+            // an unchanged character is left out rather than sent empty
+            if (fields == 0) {
+                return false;
+            }
+            character = baseline_characters[baseline_index++];
+        }
+        if (not read_field(fields, position_x_bit, character.position_x) or
+            not read_field(fields, position_y_bit, character.position_y) or
+            not read_field(fields, velocity_x_bit, character.velocity_x) or
+            not read_field(fields, velocity_y_bit, character.velocity_y)) {
+            return false;
+        }
+        world_snapshot.characters.push_back(character);
+    }
+    while (baseline_index < baseline_characters.size()) {
+        world_snapshot.characters.push_back(baseline_characters[baseline_index++]);
+    }
+    return world_snapshot.characters.size() <= max_characters_per_snapshot;
+}
+
+bool decode_keyboard_update_batch(const void *data, size_t size, std::vector<KeyboardUpdate> &keyboard_updates,
+                                  int &acknowledged_world_snapshot_id) {
+    std::span<const char> bytes(static_cast<const char *>(data), size);
+    ByteReader reader(bytes);
+    keyboard_updates.clear();
+
+    uint32_t client_id;
+    uint32_t shifted_acknowledged_world_snapshot_id;
+    uint64_t count;
+    if (not reader.read_header(MessageType::keyboard_update_batch) or not reader.read_uint32(client_id) or
+        not reader.read_uint32(shifted_acknowledged_world_snapshot_id) or
+        shifted_acknowledged_world_snapshot_id > static_cast<uint32_t>(INT_MAX) + 1 or
+        not reader.read_varint(count) or count > max_keyboard_updates_per_batch) {
+        return false;
+    }
+    acknowledged_world_snapshot_id = static_cast<int>(static_cast<int64_t>(shifted_acknowledged_world_snapshot_id) - 1);
+    if (count == 0) {
+        return reader.fully_consumed();
+    }
+
+    uint32_t first_id;
+    uint8_t keys;
+    // every id in the batch has to fit in an int, past that they would wrap around to negative ids
+    if (not reader.read_uint32(first_id) or first_id + count - 1 > INT_MAX or not reader.read_byte(keys) or
+        keys & ~all_key_bits) {
+        return false;
+    }
+
+    auto append = [&]() {
+        KeyboardUpdate keyboard_update;
+        keyboard_update.client_id = client_id;
+        keyboard_update.id = static_cast<int>(first_id + keyboard_updates.size());
+        unpack_keys(keys, keyboard_update);
+        keyboard_updates.push_back(keyboard_update);
+    };
+
+    append();
+    while (keyboard_updates.size() < count) {
+        uint64_t repeats;
+        if (not reader.read_varint(repeats) or repeats > count - keyboard_updates.size()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < repeats; i++) {
+            append();
+        }
+        if (keyboard_updates.size() == count) {
+            break;
+        }
+        uint8_t flipped_keys;
+        // a change that flips nothing would just be a longer run, so it can only come from a broken encoder
+        if (not reader.read_byte(flipped_keys) or flipped_keys == 0 or flipped_keys & ~all_key_bits) {
+            return false;
+        }
+        keys ^= flipped_keys;
+        append();
+    }
+    return reader.fully_consumed();
+}
+
+} // namespace wire_format
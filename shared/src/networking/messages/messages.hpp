@@ -0,0 +1,198 @@
+#ifndef MESSAGES_HPP
+#define MESSAGES_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+/**
+ * @brief the messages the client and server exchange and the compact format they travel in
+ *
+ * @note the structs are what the rest of the code works with, they never go over the wire as is. Every packet starts
+ * with one header byte holding the format version and the message type, ids are varints, positions and velocities
+ * are fixed point varints and the keys are packed into a single byte. Decoding reads straight out of the received
+ * bytes and rejects anything that has the wrong version, runs past the end, or has bytes left over.
+ */
+
+struct ClientIdAssignment {
+    unsigned int client_id;
+};
+
+struct KeyboardUpdate {
+    unsigned int client_id;
+    int id;
+    bool forward_pressed = false;
+    bool backwards_pressed = false;
+    bool left_pressed = false;
+    bool right_pressed = false;
+
+    friend std::ostream &operator<<(std::ostream &os, const KeyboardUpdate &update) {
+        os << "KeyboardUpdate{client_id: " << update.client_id << ", id: " << update.id
+           << ", forward_pressed: " << update.forward_pressed << ", backwards_pressed: " << update.backwards_pressed
+           << ", left_pressed: " << update.left_pressed << ", right_pressed: " << update.right_pressed << "}";
+        return os;
+    }
+};
+
+struct GameUpdate {
+    double position_x;
+    double position_y;
+    double velocity_x;
+    double velocity_y;
+
+    int last_id_used_to_produce_this_update;
+
+    // how many ticks more of this client's input the server has buffered than it wants, the client makes input a
+    // little slower while it's positive and a little faster while it's negative
+    double input_lead = 0;
+
+    // Overloading the << operator
+    friend std::ostream &operator<<(std::ostream &os, const GameUpdate &update) {
+        os << "GameUpdate { position: " << update.position_x << ", " << update.position_y
+           << ", last_id_used_to_produce_this_update: " << update.last_id_used_to_produce_this_update
+           << ", input_lead: " << update.input_lead << " }";
+        return os;
+    }
+};
+
+/**
+ * @brief another character as of some server tick, positions and velocities are counted in fixed point steps (see
+ * wire_format::fixed_point_scale) because that is how they travel, so what the server remembers sending and what the
+ * client rebuilds from it are exactly the same numbers and deltas between them are exact
+ */
+struct CharacterSnapshot {
+    unsigned int client_id;
+    int32_t position_x;
+    int32_t position_y;
+    int32_t velocity_x;
+    int32_t velocity_y;
+
+    bool operator==(const CharacterSnapshot &other) const = default;
+};
+
+/**
+ * @brief the characters near one client at one server tick, sorted by client id
+ */
+struct WorldSnapshot {
+    int id;
+    std::vector<CharacterSnapshot> characters;
+};
+
+namespace wire_format {
+
+constexpr uint8_t version = 1;
+
+enum class MessageType : uint8_t {
+    client_id_assignment = 0,
+    keyboard_update = 1,
+    game_update = 2,
+    keyboard_update_batch = 3,
+    world_snapshot = 4,
+};
+
+/**
+ * @brief positions and velocities are sent as integers counting steps of this size, 1/65536 is far below anything
+ * visible but still keeps a typical game update around a third of the raw struct
+ */
+constexpr double fixed_point_scale = 65536.0;
+
+int32_t to_fixed_point(double value);
+double from_fixed_point(int32_t steps);
+
+/**
+ * @brief the most keyboard updates a single batch carries, if more are unacknowledged only the newest go out since
+ * the server has either used or given up on the older ones by then
+ */
+constexpr size_t max_keyboard_updates_per_batch = 256;
+
+/**
+ * @brief the most characters a single world snapshot describes, the server keeps the nearest ones, this keeps a
+ * snapshot where everyone changed under a typical mtu
+ */
+constexpr size_t max_characters_per_snapshot = 32;
+
+// sized for the larger of a batch where every input differs from the last and a world snapshot where every character
+// changed every field and as many again left, every other message is a few dozen bytes at most
+constexpr size_t max_message_size =
+    std::max(16 + 2 * max_keyboard_updates_per_batch, 16 + 32 * max_characters_per_snapshot);
+
+/**
+ * @brief an encoded message living on the stack, send data.data() with size bytes
+ */
+struct EncodedMessage {
+    std::array<char, max_message_size> data;
+    size_t size = 0;
+};
+
+EncodedMessage encode(const ClientIdAssignment &client_id_assignment);
+EncodedMessage encode(const KeyboardUpdate &keyboard_update);
+EncodedMessage encode(const GameUpdate &game_update);
+
+/**
+ * @brief packs a run of keyboard updates with consecutive ids into one message, each input after the first is stored
+ * as how many times the previous one repeats followed by the keys that flipped, so held keys cost almost nothing
+ *
+ * @note only the last max_keyboard_updates_per_batch updates are encoded if there are more
+ *
+ * @param acknowledged_world_snapshot_id the newest world snapshot the sender has, the server encodes the next ones
+ * relative to it, -1 if it has none
+ */
+EncodedMessage encode_keyboard_update_batch(unsigned int client_id, std::span<const KeyboardUpdate> keyboard_updates,
+                                            int acknowledged_world_snapshot_id = -1);
+
+/**
+ * @brief encodes only what changed since baseline, a world snapshot the receiver already has: characters that didn't
+ * change are left out entirely, the ones that did only carry the fields that changed as differences, and characters
+ * that are gone are listed by id. Without a baseline every character is sent in full.
+ *
+ * @note both snapshots have to be sorted by client id and hold at most max_characters_per_snapshot characters
+ */
+EncodedMessage encode_world_snapshot(const WorldSnapshot &world_snapshot, const WorldSnapshot *baseline);
+
+// decoding takes the same pointer and size the networking code hands around, it reads in place without copying
+
+/**
+ * @brief reads the header byte, returns nothing if the packet is empty, from another version or of an unknown type
+ */
+std::optional<MessageType> peek_message_type(const void *data, size_t size);
+
+std::optional<ClientIdAssignment> decode_client_id_assignment(const void *data, size_t size);
+std::optional<KeyboardUpdate> decode_keyboard_update(const void *data, size_t size);
+std::optional<GameUpdate> decode_game_update(const void *data, size_t size);
+
+struct WorldSnapshotHeader {
+    int id;
+    std::optional<int> baseline_id;
+};
+
+/**
+ * @brief reads which snapshot this is and which one it was encoded against, so the receiver can find the baseline to
+ * pass to decode_world_snapshot
+ */
+std::optional<WorldSnapshotHeader> peek_world_snapshot_header(const void *data, size_t size);
+
+/**
+ * @brief rebuilds the full snapshot into world_snapshot from the encoded changes and the baseline they are relative
+ * to, which must be the one named in the header or nullptr if there is none
+ *
+ * @return false if the snapshot is malformed or the baseline doesn't match, world_snapshot is left in an unspecified
+ * state then
+ */
+bool decode_world_snapshot(const void *data, size_t size, const WorldSnapshot *baseline, WorldSnapshot &world_snapshot);
+
+/**
+ * @brief decodes a batch into keyboard_updates, which is cleared first so the caller can keep reusing its capacity
+ *
+ * @return false if the batch is malformed, keyboard_updates is left in an unspecified state then
+ */
+bool decode_keyboard_update_batch(const void *data, size_t size, std::vector<KeyboardUpdate> &keyboard_updates,
+                                  int &acknowledged_world_snapshot_id);
+
+} // namespace wire_format
+
+#endif // MESSAGES_HPP
@@ -0,0 +1,131 @@
+#include "remote_character_interpolator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// how much of the difference between a new clock offset measurement and our estimate is taken on, the rest is
+// assumed to be jitter
+constexpr double clock_offset_smoothing = 0.05;
+// past this the estimate is wrong rather than noisy, a reconnect or a stall, so it's replaced outright
+constexpr double clock_offset_resync_threshold = 0.5;
+
+/**
+ * @brief cubic hermite between two samples, using their velocities as the tangents gives a curve that leaves and
+ * arrives in the direction the character was actually moving
+ */
+glm::vec2 hermite(glm::vec2 position_a, glm::vec2 velocity_a, glm::vec2 position_b, glm::vec2 velocity_b,
+                  float duration, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return position_a * (2 * t3 - 3 * t2 + 1) + velocity_a * (duration * (t3 - 2 * t2 + t)) +
+           position_b * (-2 * t3 + 3 * t2) + velocity_b * (duration * (t3 - t2));
+}
+} // namespace
+
+RemoteCharacterInterpolator::RemoteCharacterInterpolator(Settings settings) : settings(settings) {}
+
+RemoteCharacterInterpolator::Sample &RemoteCharacterInterpolator::get_sample(size_t slot_index, uint32_t index) {
+    const Slot &slot = slots[slot_index];
+    return samples[slot_index * samples_per_character + ((slot.first_sample + index) & (samples_per_character - 1))];
+}
+
+size_t RemoteCharacterInterpolator::acquire_slot(unsigned int client_id) {
+    size_t slot_index;
+    if (free_slots.empty()) {
+        slot_index = slots.size();
+        slots.emplace_back();
+        samples.resize(slots.size() * samples_per_character);
+    } else {
+        slot_index = free_slots.back();
+        free_slots.pop_back();
+    }
+    slots[slot_index] = Slot{true, client_id};
+    client_id_to_slot[client_id] = slot_index;
+    return slot_index;
+}
+
+void RemoteCharacterInterpolator::release_slot(size_t slot_index) {
+    client_id_to_slot.erase(slots[slot_index].client_id);
+    slots[slot_index].in_use = false;
+    free_slots.push_back(slot_index);
+}
+
+void RemoteCharacterInterpolator::add_world_snapshot(const WorldSnapshot &world_snapshot, double server_time,
+                                                     double local_time) {
+    double measured_clock_offset = server_time - local_time;
+    if (not clock_offset.has_value() or
+        std::abs(measured_clock_offset - clock_offset.value()) > clock_offset_resync_threshold) {
+        clock_offset = measured_clock_offset;
+    } else {
+        clock_offset.value() += clock_offset_smoothing * (measured_clock_offset - clock_offset.value());
+    }
+
+    for (const CharacterSnapshot &character : world_snapshot.characters) {
+        auto it = client_id_to_slot.find(character.client_id);
+        size_t slot_index = it == client_id_to_slot.end() ? acquire_slot(character.client_id) : it->second;
+        Slot &slot = slots[slot_index];
+        slot.last_seen_server_time = server_time;
+        slot.removal_server_time = std::nullopt;
+
+        // full means the oldest sample is far behind the render time anyway
+        if (slot.num_samples == samples_per_character) {
+            slot.first_sample++;
+            slot.num_samples--;
+        }
+        get_sample(slot_index, slot.num_samples++) = {
+            server_time,
+            glm::vec2(wire_format::from_fixed_point(character.position_x),
+                      wire_format::from_fixed_point(character.position_y)),
+            glm::vec2(wire_format::from_fixed_point(character.velocity_x),
+                      wire_format::from_fixed_point(character.velocity_y))};
+    }
+
+    for (Slot &slot : slots) {
+        if (slot.in_use and slot.last_seen_server_time < server_time and not slot.removal_server_time.has_value()) {
+            slot.removal_server_time = server_time;
+        }
+    }
+}
+
+void RemoteCharacterInterpolator::sample(double local_time, std::vector<RemoteCharacter> &remote_characters) {
+    remote_characters.clear();
+    if (not clock_offset.has_value()) {
+        return;
+    }
+    double render_time = local_time + clock_offset.value() - settings.interpolation_delay;
+
+    for (size_t slot_index = 0; slot_index < slots.size(); slot_index++) {
+        Slot &slot = slots[slot_index];
+        if (not slot.in_use) {
+            continue;
+        }
+        if (slot.removal_server_time.has_value() and render_time >= slot.removal_server_time.value()) {
+            release_slot(slot_index);
+            continue;
+        }
+
+        // render time only moves forward, so once the next sample is behind it the current one is never needed again
+        // and in the common case this leaves the pair to interpolate between at the front
+        while (slot.num_samples >= 2 and get_sample(slot_index, 1).server_time <= render_time) {
+            slot.first_sample++;
+            slot.num_samples--;
+        }
+
+        const Sample &from = get_sample(slot_index, 0);
+        glm::vec2 position;
+        if (render_time <= from.server_time) {
+            // only just appeared, we have nothing from before it to come from
+            position = from.position;
+        } else if (slot.num_samples >= 2) {
+            const Sample &to = get_sample(slot_index, 1);
+            double duration = to.server_time - from.server_time;
+            position = hermite(from.position, from.velocity, to.position, to.velocity, static_cast<float>(duration),
+                               static_cast<float>((render_time - from.server_time) / duration));
+        } else {
+            double extrapolation = std::min(render_time - from.server_time, settings.max_extrapolation);
+            position = from.position + from.velocity * static_cast<float>(extrapolation);
+        }
+        remote_characters.push_back({slot.client_id, position});
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef REMOTE_CHARACTER_INTERPOLATOR_HPP
+#define REMOTE_CHARACTER_INTERPOLATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../messages/messages.hpp"
+
+/**
+ * @brief where the other characters are drawn, every world snapshot adds a timestamped sample per character and
+ * they're drawn a fixed delay in the past, between two samples that actually arrived, so they move smoothly at the
+ * frame rate instead of stepping at the snapshot rate and freezing whenever a packet is lost
+ *
+ * @note when the samples run out, because packets were lost or late, characters carry on along their last velocity
+ * for at most max_extrapolation and then hold still until the next sample arrives
+ */
+class RemoteCharacterInterpolator {
+  public:
+    struct Settings {
+        // how far in the past characters are drawn, more hides longer gaps between snapshots but adds latency
+        double interpolation_delay = 0.1;
+        double max_extrapolation = 0.25;
+    };
+
+    struct RemoteCharacter {
+        unsigned int client_id;
+        glm::vec2 position;
+    };
+
+    explicit RemoteCharacterInterpolator(Settings settings);
+
+    /**
+     * @brief adds a sample for every character in the snapshot, characters that aren't in it anymore disappear once
+     * rendering reaches server_time
+     *
+     * @param server_time when the server produced the snapshot, has to increase with every call
+     * @param local_time when it arrived on our clock, used to keep track of how the two clocks relate
+     */
+    void add_world_snapshot(const WorldSnapshot &world_snapshot, double server_time, double local_time);
+
+    /**
+     * @brief replaces remote_characters with where every character should be drawn at local_time, which has to
+     * increase with every call, samples that are too old to matter anymore are discarded along the way
+     */
+    void sample(double local_time, std::vector<RemoteCharacter> &remote_characters);
+
+    size_t get_num_characters() const { return client_id_to_slot.size(); }
+
+  private:
+    // 16 snapshots at 60Hz is well past the interpolation delay plus a few lost packets, a power of two so the
+    // index wraps with a mask
+    static constexpr size_t samples_per_character = 16;
+
+    struct Sample {
+        double server_time;
+        glm::vec2 position;
+        glm::vec2 velocity;
+    };
+
+    /**
+     * @brief everything a character has apart from its samples, which live in its own run of the shared samples array
+     */
+    struct Slot {
+        bool in_use = false;
+        unsigned int client_id = 0;
+        uint32_t first_sample = 0;
+        uint32_t num_samples = 0;
+        double last_seen_server_time = 0;
+        std::optional<double> removal_server_time = std::nullopt;
+    };
+
+    Sample &get_sample(size_t slot_index, uint32_t index);
+    size_t acquire_slot(unsigned int client_id);
+    void release_slot(size_t slot_index);
+
+    Settings settings;
+
+    // slot i owns samples [i * samples_per_character, (i + 1) * samples_per_character) as a ring starting at its
+    // first_sample, so sampling walks memory in order
+    std::vector<Sample> samples;
+    std::vector<Slot> slots;
+    std::vector<size_t> free_slots;
+    std::unordered_map<unsigned int, size_t> client_id_to_slot;
+
+    // server time minus local time, smoothed so a single late packet doesn't make everyone jump
+    std::optional<double> clock_offset;
+};
+
+#endif // REMOTE_CHARACTER_INTERPOLATOR_HPP
@@ -0,0 +1,63 @@
+#include "world_replication.hpp"
+
+#include <algorithm>
+
+void gather_nearby_characters(const SpatialGrid &spatial_grid, std::span<const CharacterSnapshot> characters,
+                              glm::vec2 center, float radius, unsigned int excluded_client_id,
+                              std::vector<unsigned int> &nearby_ids,
+                              std::vector<CharacterSnapshot> &nearby_characters) {
+    nearby_ids.clear();
+    spatial_grid.query(center, radius, nearby_ids);
+    std::erase_if(nearby_ids, [&](unsigned int id) { return characters[id].client_id == excluded_client_id; });
+
+    if (nearby_ids.size() > wire_format::max_characters_per_snapshot) {
+        auto distance_squared = [&](unsigned int id) {
+            double x = wire_format::from_fixed_point(characters[id].position_x) - center.x;
+            double y = wire_format::from_fixed_point(characters[id].position_y) - center.y;
+            return x * x + y * y;
+        };
+        // ties are broken by id so that which of two equally far characters is kept doesn't depend on the query
+        std::nth_element(nearby_ids.begin(), nearby_ids.begin() + wire_format::max_characters_per_snapshot,
+                         nearby_ids.end(), [&](unsigned int a, unsigned int b) {
+                             double distance_a = distance_squared(a);
+                             double distance_b = distance_squared(b);
+                             return distance_a != distance_b ? distance_a < distance_b : a < b;
+                         });
+        nearby_ids.resize(wire_format::max_characters_per_snapshot);
+    }
+
+    size_t first_nearby_character = nearby_characters.size();
+    for (unsigned int id : nearby_ids) {
+        nearby_characters.push_back(characters[id]);
+    }
+    std::sort(nearby_characters.begin() + first_nearby_character, nearby_characters.end(),
+              [](const CharacterSnapshot &a, const CharacterSnapshot &b) { return a.client_id < b.client_id; });
+}
+
+bool WorldReplication::acknowledge(int world_snapshot_id) {
+    // only ids we actually sent count, anything else is a confused or lying client
+    if (not sent_snapshots.contains(world_snapshot_id)) {
+        return false;
+    }
+    if (not acknowledged_snapshot_id.has_value() or world_snapshot_id > acknowledged_snapshot_id.value()) {
+        acknowledged_snapshot_id = world_snapshot_id;
+        return true;
+    }
+    return false;
+}
+
+wire_format::EncodedMessage
+WorldReplication::encode_next_snapshot(int world_snapshot_id, std::span<const CharacterSnapshot> nearby_characters) {
+    // nothing older than the acknowledged snapshot can be a baseline again
+    if (acknowledged_snapshot_id.has_value()) {
+        sent_snapshots.discard_up_to_and_including(acknowledged_snapshot_id.value() - 1);
+    }
+
+    // filled in place so the slot reuses the characters vector it had last time around
+    WorldSnapshot *world_snapshot = sent_snapshots.insert(world_snapshot_id, WorldSnapshot{world_snapshot_id, {}});
+    world_snapshot->characters.assign(nearby_characters.begin(), nearby_characters.end());
+
+    const WorldSnapshot *baseline =
+        acknowledged_snapshot_id.has_value() ? sent_snapshots.find(acknowledged_snapshot_id.value()) : nullptr;
+    return wire_format::encode_world_snapshot(*world_snapshot, baseline);
+}
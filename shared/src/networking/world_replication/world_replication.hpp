@@ -0,0 +1,53 @@
+#ifndef WORLD_REPLICATION_HPP
+#define WORLD_REPLICATION_HPP
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "../messages/messages.hpp"
+#include "../../utility/spatial_grid/spatial_grid.hpp"
+#include "../../utility/tick_ring_buffer/tick_ring_buffer.hpp"
+
+/**
+ * @brief appends to nearby_characters the characters within radius of center sorted by client id, which is how a
+ * world snapshot wants them, if there are more than fit in one snapshot only the nearest are kept
+ *
+ * @param characters everything in the world, indexed by the ids the grid was built with
+ * @param nearby_ids scratch space so that repeated calls don't allocate
+ */
+void gather_nearby_characters(const SpatialGrid &spatial_grid, std::span<const CharacterSnapshot> characters,
+                              glm::vec2 center, float radius, unsigned int excluded_client_id,
+                              std::vector<unsigned int> &nearby_ids, std::vector<CharacterSnapshot> &nearby_characters);
+
+/**
+ * @brief what the server remembers about the world snapshots it sent one client, every snapshot is encoded relative
+ * to the newest one the client told us it has, so the bytes sent depend on how much changed near them rather than on
+ * how many characters there are
+ */
+class WorldReplication {
+  public:
+    /**
+     * @brief the client has the given snapshot, acknowledgements can arrive out of order so older ones are ignored
+     * @return whether this is newer than anything they acknowledged before, which is when it's worth timing
+     */
+    bool acknowledge(int world_snapshot_id);
+
+    /**
+     * @brief remembers what the client should now see and encodes it relative to the newest acknowledged snapshot,
+     * or in full if there is none or it has been forgotten
+     *
+     * @param world_snapshot_id has to increase with every call
+     * @param nearby_characters sorted by client id
+     */
+    wire_format::EncodedMessage encode_next_snapshot(int world_snapshot_id,
+                                                     std::span<const CharacterSnapshot> nearby_characters);
+
+  private:
+    // one snapshot goes out per tick so this covers about half a second of round trip at 60Hz, a client that takes
+    // longer than that to acknowledge just gets full snapshots
+    TickRingBuffer<WorldSnapshot, 32> sent_snapshots;
+    std::optional<int> acknowledged_snapshot_id;
+};
+
+#endif // WORLD_REPLICATION_HPP
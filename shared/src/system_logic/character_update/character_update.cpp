@@ -0,0 +1,84 @@
+#include "character_update.hpp"
+
+#include <Jolt/Physics/Body/BodyFilter.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
+#include <Jolt/Physics/Collision/ObjectLayer.h>
+#include <Jolt/Physics/Collision/ShapeFilter.h>
+
+namespace {
+
+/**
+ * @note a straight loop over arrays that don't overlap with no branches in it is what the compiler turns into simd,
+ * keep it that way
+ */
+void step_character_velocities(float *__restrict velocity_x, float *__restrict velocity_y,
+                               const float *__restrict input_x, const float *__restrict input_y, size_t num_characters,
+                               float delta_time) {
+    const float acceleration_this_tick = character_acceleration * delta_time;
+    for (size_t i = 0; i < num_characters; i++) {
+        velocity_x[i] = (velocity_x[i] + input_x[i] * acceleration_this_tick) * character_friction;
+        velocity_y[i] = (velocity_y[i] + input_y[i] * acceleration_this_tick) * character_friction;
+    }
+}
+
+} // namespace
+
+void update_character(JPH::PhysicsSystem &physics_system, JPH::CharacterVirtual &character, float delta_time,
+                      JPH::TempAllocator &temp_allocator) {
+    // only reads the world, so this is safe to run concurrently as long as nobody is adding or moving bodies
+    character.Update(delta_time, physics_system.GetGravity(), JPH::BroadPhaseLayerFilter(), JPH::ObjectLayerFilter(),
+                     JPH::BodyFilter(), JPH::ShapeFilter(), temp_allocator);
+}
+
+glm::vec2 get_input_vector(const KeyboardUpdate &keyboard_update) {
+    return glm::vec2(
+        static_cast<int>(keyboard_update.right_pressed) - static_cast<int>(keyboard_update.left_pressed),
+        static_cast<int>(keyboard_update.forward_pressed) - static_cast<int>(keyboard_update.backwards_pressed));
+}
+
+size_t CharacterMovementStore::add() {
+    if (not free_indices.empty()) {
+        size_t index = free_indices.back();
+        free_indices.pop_back();
+        return index;
+    }
+    velocity_x.push_back(0);
+    velocity_y.push_back(0);
+    input_x.push_back(0);
+    input_y.push_back(0);
+    return size() - 1;
+}
+
+void CharacterMovementStore::remove(size_t index) {
+    velocity_x[index] = 0;
+    velocity_y[index] = 0;
+    input_x[index] = 0;
+    input_y[index] = 0;
+    free_indices.push_back(index);
+}
+
+void CharacterMovementStore::set_input(size_t index, const KeyboardUpdate &keyboard_update) {
+    glm::vec2 input_vector = get_input_vector(keyboard_update);
+    input_x[index] = input_vector.x;
+    input_y[index] = input_vector.y;
+}
+
+void CharacterMovementStore::set_velocity(size_t index, glm::vec2 velocity) {
+    velocity_x[index] = velocity.x;
+    velocity_y[index] = velocity.y;
+}
+
+void step_character_velocities(CharacterMovementStore &store, float delta_time) {
+    step_character_velocities(store.velocity_x.data(), store.velocity_y.data(), store.input_x.data(),
+                              store.input_y.data(), store.size(), delta_time);
+}
+
+void move_character(JPH::PhysicsSystem &physics_system, JPH::CharacterVirtual &character, CharacterMovementStore &store,
+                    size_t index, float delta_time, JPH::TempAllocator &temp_allocator) {
+    glm::vec2 velocity = store.get_velocity(index);
+    character.SetLinearVelocity(JPH::Vec3(velocity.x, velocity.y, 0));
+    update_character(physics_system, character, delta_time, temp_allocator);
+    // sliding along or stopping against something changes the velocity, which is what jolt would have carried on with
+    JPH::Vec3 collided_velocity = character.GetLinearVelocity();
+    store.set_velocity(index, glm::vec2(collided_velocity.GetX(), collided_velocity.GetY()));
+}
@@ -0,0 +1,76 @@
+#ifndef CHARACTER_UPDATE_HPP
+#define CHARACTER_UPDATE_HPP
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Character/CharacterVirtual.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "../../networking/messages/messages.hpp"
+
+// how hard input pushes a character and how much of its velocity it keeps every tick
+constexpr float character_acceleration = 10 * 0.01;
+constexpr float character_friction = 0.99;
+
+/**
+ * @brief the velocity and held input of a group of characters, each field in its own contiguous array so the
+ * movement step runs over all of them in one vectorized pass instead of going through one jolt character at a time
+ *
+ * @note a character is an index handed out by add, callers keep it next to whatever else they hold per character.
+ * A removed index is left at rest, which the movement step leaves it at, and handed out again by the next add.
+ * This is what carries velocity from one tick to the next, jolt is only handed it to move the character.
+ */
+struct CharacterMovementStore {
+    std::vector<float> velocity_x;
+    std::vector<float> velocity_y;
+    // each axis is -1, 0 or 1, see get_input_vector
+    std::vector<float> input_x;
+    std::vector<float> input_y;
+    std::vector<size_t> free_indices;
+
+    size_t add();
+    void remove(size_t index);
+    size_t size() const { return velocity_x.size(); }
+
+    void set_input(size_t index, const KeyboardUpdate &keyboard_update);
+    glm::vec2 get_velocity(size_t index) const { return glm::vec2(velocity_x[index], velocity_y[index]); }
+    void set_velocity(size_t index, glm::vec2 velocity);
+};
+
+/**
+ * @brief moves a character through the world using its current linear velocity
+ *
+ * @note Physics::update_specific_character shares one temp allocator between all calls, this takes the allocator
+ * from the caller instead so that different characters can be updated from different threads at the same time.
+ */
+void update_character(JPH::PhysicsSystem &physics_system, JPH::CharacterVirtual &character, float delta_time,
+                      JPH::TempAllocator &temp_allocator);
+
+/**
+ * @brief the direction the pressed keys point in, each axis is -1, 0 or 1
+ */
+glm::vec2 get_input_vector(const KeyboardUpdate &keyboard_update);
+
+/**
+ * @brief one tick of accelerating every character in the store along its input and applying friction
+ *
+ * @note the client and server both step through here, the server over everyone at once and the client over just its
+ * own character, so that their predictions agree
+ */
+void step_character_velocities(CharacterMovementStore &store, float delta_time);
+
+/**
+ * @brief moves a character through the world with the velocity the movement step gave it at index in the store, then
+ * writes back the velocity jolt left it with, so a character that ran into something carries on from that next tick
+ *
+ * @note only touches the store at index, so different characters can be moved from different threads at once
+ */
+void move_character(JPH::PhysicsSystem &physics_system, JPH::CharacterVirtual &character, CharacterMovementStore &store,
+                    size_t index, float delta_time, JPH::TempAllocator &temp_allocator);
+
+#endif // CHARACTER_UPDATE_HPP
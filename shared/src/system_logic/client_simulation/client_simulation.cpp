@@ -0,0 +1,282 @@
+#include "client_simulation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "../../utility/buffer_state_recorder/buffer_state_recorder.hpp"
+#include "../../utility/tracing/tracing.hpp"
+
+ClientSimulation::ClientSimulation(const Settings &settings, JPH::PhysicsSystem &physics_system,
+                                   JPH::Ref<JPH::CharacterVirtual> character)
+    : settings(settings), physics_system(physics_system), character(character), temp_allocator(1024 * 1024),
+      movement_index(character_movement.add()),
+      tick_snapshots(std::make_unique<TickRingBuffer<TickSnapshot, tick_snapshot_capacity>>()),
+      world_snapshots(std::make_unique<TickRingBuffer<WorldSnapshot, world_snapshot_capacity>>()),
+      remote_character_interpolator(
+          {settings.remote_character_interpolation_delay, settings.remote_character_max_extrapolation}),
+      input_to_ack_ms(metrics::get_histogram("input_to_ack_ms")),
+      prediction_error(metrics::get_histogram("prediction_error")),
+      replay_length_ticks(metrics::get_histogram("replay_length_ticks")),
+      replay_time_ms(metrics::get_histogram("replay_time_ms")),
+      predictions_checked(metrics::get_counter("predictions_checked")),
+      mispredictions(metrics::get_counter("mispredictions")),
+      world_snapshots_received(metrics::get_counter("world_snapshots_received")),
+      world_snapshots_lost(metrics::get_counter("world_snapshots_lost")) {
+    JPH::Vec3 character_position = character->GetPosition();
+    position = glm::vec2(character_position.GetX(), character_position.GetY());
+}
+
+ClientSimulation::TickResult ClientSimulation::tick(double delta_time, double time,
+                                                    const SampleInputFunction &sample_input,
+                                                    std::span<const std::span<const char>> packets,
+                                                    const SendFunction &send) {
+    TickResult result;
+
+    // the server simulates exactly one of our inputs per tick, so we make them at its rate, nudged by its feedback so
+    // they reach it only as early as its jitter buffer needs
+    time_until_next_input -= delta_time;
+    if (time_until_next_input <= 0) {
+        double input_period_adjustment =
+            std::clamp(settings.input_period_adjustment_per_tick_of_lead * server_input_lead,
+                       -settings.max_input_period_adjustment, settings.max_input_period_adjustment);
+        time_until_next_input += settings.simulation_period * (1 + input_period_adjustment);
+
+        KeyboardUpdate ku = sample_input();
+        ku.client_id = client_id.value_or(0);
+        ku.id = next_input_id++;
+        tick_snapshots->insert(ku.id, TickSnapshot{ku, time});
+        unsent_input.push_back(ku);
+        predict(ku.id);
+        // sent as soon as it's made, waiting for anything else would only add to the jitter the server has to absorb
+        send_input(send);
+        result.made_input = ku;
+    }
+
+    game_updates_this_tick.clear();
+    for (std::span<const char> packet : packets) {
+        receive_packet(packet, time);
+    }
+    if (not game_updates_this_tick.empty()) {
+        // when every update is kept they are in whatever order the network delivered them
+        const GameUpdate &newest_game_update = *std::max_element(
+            game_updates_this_tick.begin(), game_updates_this_tick.end(), [](const GameUpdate &a, const GameUpdate &b) {
+                return a.last_id_used_to_produce_this_update < b.last_id_used_to_produce_this_update;
+            });
+        result.reconciliation = reconcile(newest_game_update, time);
+    }
+
+    if (settings.smooth_visual_corrections) {
+        visual_correction_offset *= std::exp(-settings.visual_correction_rate * static_cast<float>(delta_time));
+    }
+    return result;
+}
+
+void ClientSimulation::sample_remote_characters(
+    double time, std::vector<RemoteCharacterInterpolator::RemoteCharacter> &remote_characters) {
+    remote_character_interpolator.sample(time, remote_characters);
+}
+
+void ClientSimulation::predict(int id) {
+    TickSnapshot *tick_snapshot = tick_snapshots->find(id);
+    if (tick_snapshot == nullptr) {
+        TRACE_DEBUG("No snapshot for id: {}, it was already reclaimed", id);
+        return;
+    }
+    float delta_time = static_cast<float>(settings.simulation_period);
+    character_movement.set_input(movement_index, tick_snapshot->input);
+    step_character_velocities(character_movement, delta_time);
+    move_character(physics_system, *character, character_movement, movement_index, delta_time, temp_allocator);
+    JPH::Vec3 character_position = character->GetPosition();
+    position = glm::vec2(character_position.GetX(), character_position.GetY());
+
+    tick_snapshot->position = position;
+    // after colliding, which is also what the server sends back
+    tick_snapshot->velocity = character_movement.get_velocity(movement_index);
+    save_character_state(*tick_snapshot);
+
+    TRACE_TRACE("Client Processing ID: {} - New Position: ({}, {})", id, position.x, position.y);
+}
+
+void ClientSimulation::send_input(const SendFunction &send) {
+    if (not settings.send_unacknowledged_input_window) {
+        if (client_id.has_value()) {
+            for (KeyboardUpdate &ku : unsent_input) {
+                ku.client_id = client_id.value();
+                send(wire_format::encode(ku));
+            }
+        }
+        unsent_input.clear();
+        return;
+    }
+
+    std::erase_if(unsent_input, [&](const KeyboardUpdate &ku) { return ku.id <= last_acknowledged_id; });
+    // more than this means the server has fallen far behind or we aren't connected yet, either way the older input
+    // will never be used
+    if (unsent_input.size() > wire_format::max_keyboard_updates_per_batch) {
+        unsent_input.erase(unsent_input.begin(), unsent_input.end() - wire_format::max_keyboard_updates_per_batch);
+    }
+    if (client_id.has_value() and not unsent_input.empty()) {
+        send(wire_format::encode_keyboard_update_batch(client_id.value(), unsent_input, newest_world_snapshot_id));
+    }
+}
+
+void ClientSimulation::receive_packet(std::span<const char> packet, double time) {
+    std::optional<wire_format::MessageType> message_type = wire_format::peek_message_type(packet.data(), packet.size());
+    if (message_type == wire_format::MessageType::client_id_assignment) {
+        std::optional<ClientIdAssignment> client_id_assignment =
+            wire_format::decode_client_id_assignment(packet.data(), packet.size());
+        if (client_id_assignment.has_value()) {
+            client_id = client_id_assignment->client_id;
+            TRACE_INFO("server assigned us client id: {}", client_id_assignment->client_id);
+            return;
+        }
+    } else if (message_type == wire_format::MessageType::game_update) {
+        std::optional<GameUpdate> game_update = wire_format::decode_game_update(packet.data(), packet.size());
+        if (game_update.has_value()) {
+            int server_id = game_update->last_id_used_to_produce_this_update;
+            // we've already reconciled against everything up to the newest acknowledged id and let go of the
+            // snapshots at and before it, so an update that was overtaken on the way has nothing to roll back to
+            if (server_id <= last_acknowledged_id) {
+                return;
+            }
+            if (settings.reconcile_against_newest_update_only) {
+                // a repeat of an id says nothing new, so only a newer id than this tick's others is worth keeping
+                if (not game_updates_this_tick.empty() and
+                    server_id <= game_updates_this_tick.back().last_id_used_to_produce_this_update) {
+                    return;
+                }
+                game_updates_this_tick.clear();
+            }
+            game_updates_this_tick.push_back(game_update.value());
+            return;
+        }
+    } else if (message_type == wire_format::MessageType::world_snapshot) {
+        std::optional<wire_format::WorldSnapshotHeader> header =
+            wire_format::peek_world_snapshot_header(packet.data(), packet.size());
+        if (header.has_value()) {
+            // anything older is already superseded, and the server never encodes against it again
+            if (header->id <= newest_world_snapshot_id) {
+                return;
+            }
+            const WorldSnapshot *baseline =
+                header->baseline_id.has_value() ? world_snapshots->find(header->baseline_id.value()) : nullptr;
+            if (header->baseline_id.has_value() and baseline == nullptr) {
+                TRACE_DEBUG("world snapshot {} is relative to {} which we no longer have", header->id,
+                            header->baseline_id.value());
+                return;
+            }
+            if (wire_format::decode_world_snapshot(packet.data(), packet.size(), baseline, decoded_world_snapshot)) {
+                world_snapshots->insert(decoded_world_snapshot.id, decoded_world_snapshot);
+                world_snapshots_received.add();
+                if (newest_world_snapshot_id >= 0) {
+                    world_snapshots_lost.add(decoded_world_snapshot.id - newest_world_snapshot_id - 1);
+                }
+                newest_world_snapshot_id = decoded_world_snapshot.id;
+                remote_character_interpolator.add_world_snapshot(
+                    decoded_world_snapshot, decoded_world_snapshot.id / settings.server_tick_rate_hz, time);
+                return;
+            }
+        }
+    }
+    TRACE_WARN("dropping malformed packet of {} bytes", packet.size());
+}
+
+ClientSimulation::Reconciliation ClientSimulation::reconcile(const GameUpdate &game_update, double time) {
+    int server_id = game_update.last_id_used_to_produce_this_update;
+    server_input_lead = game_update.input_lead;
+
+    const TickSnapshot *tick_snapshot_at_server_id = tick_snapshots->find(server_id);
+    if (tick_snapshot_at_server_id) {
+        input_to_ack_ms.record(1000 * (time - tick_snapshot_at_server_id->made_at));
+    }
+    // receive_packet only lets through ids newer than this
+    last_acknowledged_id = server_id;
+
+    glm::vec2 server_position(game_update.position_x, game_update.position_y);
+    glm::vec2 server_velocity(game_update.velocity_x, game_update.velocity_y);
+    Reconciliation reconciliation{server_id, server_position};
+    bool prediction_matches =
+        tick_snapshot_at_server_id and
+        glm::length(tick_snapshot_at_server_id->position - server_position) <= settings.mispredict_epsilon and
+        glm::length(tick_snapshot_at_server_id->velocity - server_velocity) <= settings.mispredict_epsilon;
+    if (tick_snapshot_at_server_id) {
+        TRACE_TRACE("our position at id {} was ({}, {}) server says ({}, {})", server_id,
+                    tick_snapshot_at_server_id->position.x, tick_snapshot_at_server_id->position.y, server_position.x,
+                    server_position.y);
+        reconciliation.prediction_error = glm::length(tick_snapshot_at_server_id->position - server_position);
+        prediction_error.record(reconciliation.prediction_error.value());
+        predictions_checked.add();
+        mispredictions.add(not prediction_matches);
+    }
+
+    reconciliation.ticks_after_server_id = std::max(0, next_input_id - 1 - server_id);
+
+    if (settings.skip_replay_when_prediction_matches and prediction_matches) {
+        TRACE_TRACE("prediction at id {} matches the server, skipping replay of {} ticks", server_id,
+                    reconciliation.ticks_after_server_id);
+        reconciliation.replayed = false;
+        reconciliation.replay_time = 0;
+    } else {
+        TRACE_DEBUG("predicted position was: ({}, {}) now setting position to ({}, {})", position.x, position.y,
+                    server_position.x, server_position.y);
+        glm::vec2 predicted_position = position;
+        auto replay_start = std::chrono::steady_clock::now();
+
+        // roll back to exactly how we predicted the character at that id, the server only tells us position and
+        // velocity so everything else (contacts, ground state) is the best guess we have
+        bool restored = tick_snapshot_at_server_id and restore_character_state(*tick_snapshot_at_server_id);
+        double restore_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+        TRACE_DEBUG("restored full character state: {} in {}us, average save takes {}us", restored, 1e6 * restore_time,
+                    1e6 * total_state_save_time / std::max<uint64_t>(1, num_state_saves));
+
+        // slam it in
+        character->SetPosition(JPH::Vec3(server_position.x, server_position.y, 0));
+        JPH::Vec3 character_position = character->GetPosition();
+        position = glm::vec2(character_position.GetX(), character_position.GetY());
+        // the movement step carries velocity from one tick to the next, jolt is only handed it to move with
+        character_movement.set_velocity(movement_index, server_velocity);
+        for (int id = server_id + 1; id < next_input_id; id++) {
+            predict(id);
+        }
+
+        reconciliation.replayed = true;
+        reconciliation.replay_time =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+        replay_length_ticks.record(reconciliation.ticks_after_server_id);
+        replay_time_ms.record(1000 * reconciliation.replay_time);
+
+        glm::vec2 correction = predicted_position - position;
+        if (settings.smooth_visual_corrections) {
+            // keep drawing where we were and let the offset drain away instead of jumping
+            visual_correction_offset += correction;
+        }
+        TRACE_DEBUG("position before reconciliation was: ({}, {}) after reconciliation was ({}, {})\n"
+                    "the delta (predicted - reconciled): {}",
+                    predicted_position.x, predicted_position.y, position.x, position.y, glm::length(correction));
+    }
+
+    // replay only ever starts after the newest acknowledged id, so nothing at or before it is needed again
+    tick_snapshots->discard_up_to_and_including(last_acknowledged_id);
+    return reconciliation;
+}
+
+void ClientSimulation::save_character_state(TickSnapshot &tick_snapshot) {
+    auto start = std::chrono::steady_clock::now();
+    BufferStateRecorder recorder(tick_snapshot.character_state.data(), tick_snapshot.character_state.size());
+    character->SaveState(recorder);
+    tick_snapshot.character_state_size = recorder.IsFailed() ? 0 : recorder.get_size();
+    total_state_save_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    num_state_saves++;
+}
+
+bool ClientSimulation::restore_character_state(const TickSnapshot &tick_snapshot) {
+    if (tick_snapshot.character_state_size == 0) {
+        return false;
+    }
+    // RestoreState only reads, the const_cast is just to fit the recorder interface which does both
+    BufferStateRecorder recorder(const_cast<uint8_t *>(tick_snapshot.character_state.data()),
+                                 tick_snapshot.character_state.size(), tick_snapshot.character_state_size);
+    character->RestoreState(recorder);
+    return not recorder.IsFailed();
+}
@@ -0,0 +1,211 @@
+#ifndef CLIENT_SIMULATION_HPP
+#define CLIENT_SIMULATION_HPP
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Character/CharacterVirtual.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "../../networking/messages/messages.hpp"
+#include "../../networking/remote_character_interpolator/remote_character_interpolator.hpp"
+#include "../../utility/metrics/metrics.hpp"
+#include "../../utility/tick_ring_buffer/tick_ring_buffer.hpp"
+#include "../character_update/character_update.hpp"
+
+/**
+ * @brief the client half of client side prediction and server reconciliation, makes an input whenever the server
+ * needs the next one, predicts our character on it straight away and sends it, then reconciles against whatever the
+ * server says it computed and keeps track of everyone else near us
+ *
+ * @note the client and the simulation harness both run exactly this, they only differ in where input and packets
+ * come from, where messages go and what clock the times are on.
+ */
+class ClientSimulation {
+  public:
+    // how much of the character's jolt state is kept per tick for rolling back to, plenty for a character touching a
+    // handful of things, a state that doesn't fit just isn't restored
+    static constexpr size_t max_character_state_size = 2048;
+
+    struct Settings {
+        // how often our character is stepped and input is made, matching the server so predictions line up
+        double simulation_period = 1.0 / 60;
+        // the server makes one world snapshot per tick, which is how a snapshot id turns into a time
+        double server_tick_rate_hz = 60;
+        // when on every send carries all the input the server hasn't acknowledged yet in one packet instead of one
+        // packet per input, so a lost packet doesn't lose input, turn it off to compare bandwidth against the old
+        // behavior
+        bool send_unacknowledged_input_window = true;
+        // compare our prediction at the id the server used against what it computed and only replay if they
+        // disagree, the wire format quantizes to 1/65536 so the epsilon has to be above that
+        bool skip_replay_when_prediction_matches = true;
+        float mispredict_epsilon = 1e-4;
+        // only the newest game update of a tick is ever reconciled against, so drop older ones as soon as they are
+        // read, off keeps every one read and picks the newest afterwards, which ends up in the same place
+        bool reconcile_against_newest_update_only = true;
+        // hide corrections by draining the visual error away over a few frames instead of snapping to the new
+        // position
+        bool smooth_visual_corrections = true;
+        // how quickly the remaining visual error decays, per second
+        float visual_correction_rate = 15;
+        // other characters are drawn this far in the past so there are snapshots on both sides to move them between,
+        // at 60 snapshots a second this rides out a handful of lost ones in a row
+        double remote_character_interpolation_delay = 0.1;
+        // how long other characters keep moving on their own once we run out of snapshots before they stop
+        double remote_character_max_extrapolation = 0.25;
+        // the server tells us how far ahead of what its jitter buffer wants our input is arriving, and we stretch or
+        // squeeze the time between inputs by this much per tick of lead to get there, a lead of a tick is worked off
+        // in about a second
+        double input_period_adjustment_per_tick_of_lead = 0.02;
+        double max_input_period_adjustment = 0.05;
+    };
+
+    /**
+     * @brief what reconciling against the newest game update of a tick came to
+     */
+    struct Reconciliation {
+        // the newest input the server had simulated when it sent the update
+        int server_id;
+        glm::vec2 server_position;
+        // how far our prediction at server_id was from the server, nothing if we no longer had it
+        std::optional<float> prediction_error = std::nullopt;
+        // false when the prediction matched and the replay was skipped
+        bool replayed = false;
+        // everything after the server's id that we've predicted so far, which is what a replay re-simulates
+        int ticks_after_server_id = 0;
+        // spent rolling back and re-simulating, zero when it was skipped
+        double replay_time = 0;
+    };
+
+    struct TickResult {
+        // the input made and predicted this tick, if one was due
+        std::optional<KeyboardUpdate> made_input;
+        std::optional<Reconciliation> reconciliation;
+    };
+
+    // which movement keys are held, the id and client id are filled in afterwards
+    using SampleInputFunction = std::function<KeyboardUpdate()>;
+    using SendFunction = std::function<void(const wire_format::EncodedMessage &message)>;
+
+    /**
+     * @param character owned by physics, this is the only thing that moves it from now on
+     */
+    ClientSimulation(const Settings &settings, JPH::PhysicsSystem &physics_system,
+                     JPH::Ref<JPH::CharacterVirtual> character);
+
+    /**
+     * @brief makes and predicts an input if one is due, sends what the server hasn't acknowledged, then reads the
+     * packets that arrived since the last tick and reconciles against the newest game update in them
+     * @param time when the tick started, on the same clock every tick
+     * @param sample_input only called when an input is due
+     */
+    TickResult tick(double delta_time, double time, const SampleInputFunction &sample_input,
+                    std::span<const std::span<const char>> packets, const SendFunction &send);
+
+    /**
+     * @brief where the characters near us are at the given time, see RemoteCharacterInterpolator::sample
+     */
+    void sample_remote_characters(double time,
+                                  std::vector<RemoteCharacterInterpolator::RemoteCharacter> &remote_characters);
+
+    glm::vec2 get_position() const { return position; }
+    glm::vec2 get_velocity() const { return character_movement.get_velocity(movement_index); }
+    // where to draw our character, ahead of a correction that is still being drained away
+    glm::vec2 get_rendered_position() const { return position + visual_correction_offset; }
+    std::optional<unsigned int> get_client_id() const { return client_id; }
+
+  private:
+    // four seconds of input, anything the server hasn't acknowledged after that is never going to be
+    static constexpr size_t tick_snapshot_capacity = 256;
+    // the server only ever encodes against the newest world snapshot we acknowledged, which is at most a round trip
+    // old
+    static constexpr size_t world_snapshot_capacity = 32;
+
+    /**
+     * @brief everything we know about our own character at a given tick id, kept so that when the server tells us
+     * where we really were at some id we can compare against our prediction and replay the input that came after it
+     */
+    struct TickSnapshot {
+        KeyboardUpdate input;
+        // when this tick's input was made, to time how long the server takes to acknowledge it
+        double made_at = 0;
+        glm::vec2 position = glm::vec2(0);
+        glm::vec2 velocity = glm::vec2(0);
+        // everything jolt keeps about the character after this tick (contacts, ground state, ...) via its SaveState,
+        // so a rollback puts it back exactly as it was instead of only moving it
+        std::array<uint8_t, max_character_state_size> character_state{};
+        size_t character_state_size = 0;
+    };
+
+    void predict(int id);
+    void send_input(const SendFunction &send);
+    void receive_packet(std::span<const char> packet, double time);
+    Reconciliation reconcile(const GameUpdate &game_update, double time);
+    void save_character_state(TickSnapshot &tick_snapshot);
+    /**
+     * @return false if there was nothing to restore, in which case the character is untouched
+     */
+    bool restore_character_state(const TickSnapshot &tick_snapshot);
+
+    Settings settings;
+    JPH::PhysicsSystem &physics_system;
+    JPH::Ref<JPH::CharacterVirtual> character;
+    // the same stepping code as the server uses so that our predictions line up with what it computes
+    JPH::TempAllocatorImpl temp_allocator;
+    // only ever holds our own character, but goes through the same movement step the server runs over everyone
+    CharacterMovementStore character_movement;
+    size_t movement_index;
+    glm::vec2 position = glm::vec2(0);
+
+    // allocated once up front, ids the server has acknowledged get reclaimed so this never grows
+    std::unique_ptr<TickRingBuffer<TickSnapshot, tick_snapshot_capacity>> tick_snapshots;
+    double total_state_save_time = 0;
+    uint64_t num_state_saves = 0;
+
+    // the id the next input we make gets
+    int next_input_id = 0;
+    double time_until_next_input = 0;
+    // from the newest game update, see input_period_adjustment_per_tick_of_lead
+    double server_input_lead = 0;
+    // assigned by the server on connect, until then it has nothing to attribute our input to
+    std::optional<unsigned int> client_id;
+    std::vector<KeyboardUpdate> unsent_input;
+    // the newest id the server has told us it used, everything up to and including it never needs sending again
+    int last_acknowledged_id = -1;
+    std::vector<GameUpdate> game_updates_this_tick;
+
+    // the other characters near us, kept by snapshot id since the server sends each one relative to an older one
+    std::unique_ptr<TickRingBuffer<WorldSnapshot, world_snapshot_capacity>> world_snapshots;
+    // the newest one we have, the server is told about it with every input batch
+    int newest_world_snapshot_id = -1;
+    WorldSnapshot decoded_world_snapshot;
+    RemoteCharacterInterpolator remote_character_interpolator;
+
+    // the difference between where we drew our character and where reconciliation moved it, drawn on top of the
+    // real position and shrunk every tick
+    glm::vec2 visual_correction_offset = glm::vec2(0);
+
+    // from making an input to the server telling us it used it, so the round trip plus however long it queued there
+    metrics::Histogram &input_to_ack_ms;
+    // how far our prediction was from the server at the id it acknowledged, whether or not that caused a replay
+    metrics::Histogram &prediction_error;
+    metrics::Histogram &replay_length_ticks;
+    metrics::Histogram &replay_time_ms;
+    metrics::Counter &predictions_checked;
+    metrics::Counter &mispredictions;
+    metrics::Counter &world_snapshots_received;
+    // skipped over ids, every tick the server makes one so a gap is a snapshot that was lost or arrived too late
+    metrics::Counter &world_snapshots_lost;
+};
+
+#endif // CLIENT_SIMULATION_HPP
@@ -0,0 +1,217 @@
+#include "server_simulation.hpp"
+
+#include <algorithm>
+#include <optional>
+
+#include "../../utility/tracing/tracing.hpp"
+
+// a character costs at most a few microseconds in any of the passes, handed out one at a time the pool's bookkeeping
+// would rival the work itself, this many still spreads a few hundred clients over every worker
+constexpr size_t characters_per_task = 32;
+
+ServerSimulation::ServerSimulation(const Settings &settings, JPH::PhysicsSystem &physics_system, WorkStealingPool &pool)
+    : settings(settings), physics_system(physics_system), pool(pool), spatial_grid(settings.interest_radius),
+      worker_nearby_ids(pool.get_num_workers()), worker_nearby_characters(pool.get_num_workers()),
+      round_trip_time_ms(metrics::get_histogram("round_trip_time_ms")),
+      inputs_processed(metrics::get_counter("inputs_processed")),
+      input_underruns(metrics::get_counter("input_underruns")),
+      ticks_without_input(metrics::get_counter("ticks_without_input")),
+      input_buffer_depth_ticks(metrics::get_histogram("input_buffer_depth_ticks")) {
+    for (unsigned int i = 0; i < pool.get_num_workers(); i++) {
+        worker_temp_allocators.push_back(std::make_unique<JPH::TempAllocatorImpl>(1024 * 1024));
+    }
+}
+
+wire_format::EncodedMessage ServerSimulation::connect_client(unsigned int client_id,
+                                                             JPH::Ref<JPH::CharacterVirtual> physics_character) {
+    ConnectedClient &client = client_id_to_connected_client[client_id];
+    client.client_id = client_id;
+    client.physics_character = physics_character;
+    JPH::Vec3 position = physics_character->GetPosition();
+    client.position = glm::vec2(position.GetX(), position.GetY());
+    client.movement_index = character_movement.add();
+    client.input_buffer = InputJitterBuffer({settings.tick_period});
+    connected_clients_in_order.insert(std::upper_bound(connected_clients_in_order.begin(),
+                                                       connected_clients_in_order.end(), client_id,
+                                                       [](unsigned int client_id, const ConnectedClient *other) {
+                                                           return client_id < other->client_id;
+                                                       }),
+                                      &client);
+    return wire_format::encode(ClientIdAssignment{client_id});
+}
+
+void ServerSimulation::disconnect_client(unsigned int client_id) {
+    auto it = client_id_to_connected_client.find(client_id);
+    if (it == client_id_to_connected_client.end()) {
+        TRACE_WARN("disconnect of unknown client: {}", client_id);
+        return;
+    }
+    ConnectedClient &client = it->second;
+    connected_clients_in_order.erase(
+        std::find(connected_clients_in_order.begin(), connected_clients_in_order.end(), &client));
+    character_movement.remove(client.movement_index);
+    client_id_to_connected_client.erase(it);
+}
+
+const ServerSimulation::ConnectedClient *ServerSimulation::find_client(unsigned int client_id) const {
+    auto it = client_id_to_connected_client.find(client_id);
+    return it == client_id_to_connected_client.end() ? nullptr : &it->second;
+}
+
+bool ServerSimulation::receive_packet(unsigned int client_id, std::span<const char> packet, double time) {
+    std::optional<wire_format::MessageType> message_type = wire_format::peek_message_type(packet.data(), packet.size());
+    std::optional<KeyboardUpdate> keyboard_update;
+    int acknowledged_world_snapshot_id;
+    if (message_type == wire_format::MessageType::keyboard_update) {
+        keyboard_update = wire_format::decode_keyboard_update(packet.data(), packet.size());
+        if (not keyboard_update.has_value()) {
+            return false;
+        }
+    } else if (message_type != wire_format::MessageType::keyboard_update_batch or
+               not wire_format::decode_keyboard_update_batch(packet.data(), packet.size(), decoded_keyboard_updates,
+                                                             acknowledged_world_snapshot_id)) {
+        return false;
+    }
+
+    // a packet can still be in flight when its sender disconnects
+    auto it = client_id_to_connected_client.find(client_id);
+    if (it == client_id_to_connected_client.end()) {
+        TRACE_WARN("packet from unknown client: {}", client_id);
+        return true;
+    }
+    ConnectedClient &client = it->second;
+
+    // clients resend everything we haven't acknowledged, the jitter buffer ignores what it already has
+    if (keyboard_update.has_value()) {
+        TRACE_TRACE("keyboard update just received: {} from client: {}", keyboard_update->id, client_id);
+        client.input_buffer.receive(keyboard_update.value(), time);
+        return true;
+    }
+    for (const KeyboardUpdate &keyboard_update : decoded_keyboard_updates) {
+        TRACE_TRACE("keyboard update just received: {} from client: {}", keyboard_update.id, client_id);
+        client.input_buffer.receive(keyboard_update, time);
+    }
+    if (client.world_replication.acknowledge(acknowledged_world_snapshot_id)) {
+        const double *send_time = world_snapshot_send_times.find(acknowledged_world_snapshot_id);
+        if (send_time != nullptr) {
+            round_trip_time_ms.record(1000 * (time - *send_time));
+        }
+    }
+    return true;
+}
+
+void ServerSimulation::tick(float delta_time, double time, const SendFunction &send) {
+    std::function<void(size_t, unsigned int)> consume_input = [&](size_t index, unsigned int) {
+        ConnectedClient &client = *connected_clients_in_order[index];
+        input_buffer_depth_ticks.record(client.input_buffer.get_depth());
+        uint64_t num_underruns_before = client.input_buffer.get_num_underruns();
+        std::optional<KeyboardUpdate> input = client.input_buffer.consume();
+        input_underruns.add(client.input_buffer.get_num_underruns() - num_underruns_before);
+        if (input.has_value()) {
+            inputs_processed.add();
+            character_movement.set_input(client.movement_index, input.value());
+            TRACE_TRACE("processing id: {} for client: {}", input->id, client.client_id);
+        } else {
+            // either their first input hasn't arrived or they've stopped sending, stop the character where it is rather
+            // than keep it going on a guess, the movement step leaves characters at rest alone
+            ticks_without_input.add();
+            character_movement.set_input(client.movement_index, KeyboardUpdate{});
+            character_movement.set_velocity(client.movement_index, glm::vec2(0));
+        }
+    };
+
+    // characters don't collide with each other so each one can be moved independently, every client only writes to
+    // its own state which means there's nothing to merge afterwards
+    std::function<void(size_t, unsigned int)> move_client = [&](size_t index, unsigned int worker_index) {
+        ConnectedClient &client = *connected_clients_in_order[index];
+        move_character(physics_system, *client.physics_character, character_movement, client.movement_index, delta_time,
+                       *worker_temp_allocators[worker_index]);
+        JPH::Vec3 position = client.physics_character->GetPosition();
+        client.position = glm::vec2(position.GetX(), position.GetY());
+    };
+    if (settings.buffer_input) {
+        pool.parallel_for(connected_clients_in_order.size(), consume_input, characters_per_task);
+        step_character_velocities(character_movement, delta_time);
+        pool.parallel_for(connected_clients_in_order.size(), move_client, characters_per_task);
+    } else {
+        simulate_drained_inputs(delta_time);
+    }
+
+    // the grid ids are indices into connected_clients_in_order
+    world_snapshot_id++;
+    all_characters.clear();
+    all_character_positions.clear();
+    for (const ConnectedClient *client : connected_clients_in_order) {
+        glm::vec2 velocity = character_movement.get_velocity(client->movement_index);
+        all_characters.push_back({client->client_id, wire_format::to_fixed_point(client->position.x),
+                                  wire_format::to_fixed_point(client->position.y),
+                                  wire_format::to_fixed_point(velocity.x), wire_format::to_fixed_point(velocity.y)});
+        all_character_positions.push_back(client->position);
+    }
+    spatial_grid.rebuild(all_character_positions);
+
+    std::function<void(size_t, unsigned int)> encode_world_snapshot = [&](size_t index, unsigned int worker_index) {
+        ConnectedClient &client = *connected_clients_in_order[index];
+        std::vector<CharacterSnapshot> &nearby_characters = worker_nearby_characters[worker_index];
+        nearby_characters.clear();
+        gather_nearby_characters(spatial_grid, all_characters, client.position, settings.interest_radius,
+                                 client.client_id, worker_nearby_ids[worker_index], nearby_characters);
+        client.world_snapshot_message =
+            client.world_replication.encode_next_snapshot(world_snapshot_id, nearby_characters);
+    };
+    pool.parallel_for(connected_clients_in_order.size(), encode_world_snapshot, characters_per_task);
+
+    for (ConnectedClient *connected_client : connected_clients_in_order) {
+        ConnectedClient &client = *connected_client;
+        std::optional<int> last_processed_id = client.input_buffer.get_last_consumed_id();
+        if (last_processed_id.has_value()) {
+            glm::vec2 velocity = character_movement.get_velocity(client.movement_index);
+            // there's no lead for the client to follow when nothing is held back
+            GameUpdate gu(client.position.x, client.position.y, velocity.x, velocity.y, last_processed_id.value(),
+                          settings.buffer_input ? client.input_buffer.get_lead() : 0);
+            TRACE_TRACE("sending game update to client: {} for id: {}", client.client_id,
+                        gu.last_id_used_to_produce_this_update);
+            send(client.client_id, wire_format::encode(gu));
+        }
+        send(client.client_id, client.world_snapshot_message);
+    }
+    world_snapshot_send_times.insert(world_snapshot_id, time);
+}
+
+void ServerSimulation::simulate_drained_inputs(float delta_time) {
+    size_t num_steps = 0;
+    for (ConnectedClient *client : connected_clients_in_order) {
+        client->input_buffer.drain(client->drained_inputs);
+        inputs_processed.add(client->drained_inputs.size());
+        // the character waits where it is with the velocity it has for their input to catch up, every id is still
+        // simulated exactly once so the client's prediction holds
+        if (client->drained_inputs.empty()) {
+            ticks_without_input.add();
+        }
+        num_steps = std::max(num_steps, client->drained_inputs.size());
+    }
+
+    held_velocities.resize(connected_clients_in_order.size());
+    for (size_t step = 0; step < num_steps; step++) {
+        for (size_t i = 0; i < connected_clients_in_order.size(); i++) {
+            ConnectedClient &client = *connected_clients_in_order[i];
+            if (step < client.drained_inputs.size()) {
+                character_movement.set_input(client.movement_index, client.drained_inputs[step]);
+            } else {
+                held_velocities[i] = character_movement.get_velocity(client.movement_index);
+            }
+        }
+        step_character_velocities(character_movement, delta_time);
+        for (size_t i = 0; i < connected_clients_in_order.size(); i++) {
+            ConnectedClient &client = *connected_clients_in_order[i];
+            if (step >= client.drained_inputs.size()) {
+                character_movement.set_velocity(client.movement_index, held_velocities[i]);
+                continue;
+            }
+            move_character(physics_system, *client.physics_character, character_movement, client.movement_index,
+                           delta_time, *worker_temp_allocators[0]);
+            JPH::Vec3 position = client.physics_character->GetPosition();
+            client.position = glm::vec2(position.GetX(), position.GetY());
+        }
+    }
+}
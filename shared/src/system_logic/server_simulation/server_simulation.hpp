@@ -0,0 +1,152 @@
+#ifndef SERVER_SIMULATION_HPP
+#define SERVER_SIMULATION_HPP
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Character/CharacterVirtual.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "../../networking/input_jitter_buffer/input_jitter_buffer.hpp"
+#include "../../networking/messages/messages.hpp"
+#include "../../networking/world_replication/world_replication.hpp"
+#include "../../utility/metrics/metrics.hpp"
+#include "../../utility/spatial_grid/spatial_grid.hpp"
+#include "../../utility/tick_ring_buffer/tick_ring_buffer.hpp"
+#include "../../utility/work_stealing_pool/work_stealing_pool.hpp"
+#include "../character_update/character_update.hpp"
+
+/**
+ * @brief the server half of client side prediction and server reconciliation, takes in what clients send, steps
+ * every character once per tick on the input its jitter buffer hands out and encodes what each client is sent back
+ *
+ * @note the server and the simulation harness both run exactly this, they only differ in where packets come from,
+ * where messages go and what clock the times are on. Characters are stepped on the pool, but what gets sent only ever
+ * depends on client ids, never on how the work was split between threads.
+ */
+class ServerSimulation {
+  public:
+    struct Settings {
+        // how often tick is called, every client has exactly one input simulated per tick
+        double tick_period = 1.0 / 60;
+        // clients are only told about other characters within this distance of their own
+        float interest_radius = 10;
+        // off simulates every input that arrived since the last tick back to back instead of one out of the jitter
+        // buffer, like the server used to, only there to measure what the buffer costs and saves
+        bool buffer_input = true;
+    };
+
+    /**
+     * @brief everything the server keeps about a single connection, the character is owned by physics but we hold a
+     * reference so the tick doesn't have to look it up every time
+     */
+    struct ConnectedClient {
+        unsigned int client_id;
+        JPH::Ref<JPH::CharacterVirtual> physics_character;
+        glm::vec2 position = glm::vec2(0);
+        // where this client's velocity and input live in the character movement store
+        size_t movement_index;
+        // exactly one input comes out of this per tick however unevenly they arrive
+        InputJitterBuffer input_buffer;
+        // what was simulated for them last tick, in order, when input isn't buffered
+        std::vector<KeyboardUpdate> drained_inputs;
+        WorldReplication world_replication;
+        // encoded in parallel with everyone else's and sent afterwards
+        wire_format::EncodedMessage world_snapshot_message;
+    };
+
+    using SendFunction = std::function<void(unsigned int client_id, const wire_format::EncodedMessage &message)>;
+
+    ServerSimulation(const Settings &settings, JPH::PhysicsSystem &physics_system, WorkStealingPool &pool);
+
+    /**
+     * @brief starts simulating the client's character, it stays at rest until their first input arrives
+     * @return the message to send them reliably, they stamp the id in it on every keyboard update they send us
+     */
+    wire_format::EncodedMessage connect_client(unsigned int client_id,
+                                               JPH::Ref<JPH::CharacterVirtual> physics_character);
+
+    /**
+     * @brief forgets everything about the client and frees their slot in the movement store for the next one to
+     * connect, the caller deletes the physics character afterwards
+     */
+    void disconnect_client(unsigned int client_id);
+
+    /**
+     * @brief hands the inputs and acknowledgement in a packet to the client it came from, call as packets are read
+     * @param client_id of the connection the packet came in on, the client id written inside it is never trusted
+     * @param time when it was read, on the same clock as the times tick is given
+     * @return false if the packet was malformed and nothing in it was used
+     */
+    bool receive_packet(unsigned int client_id, std::span<const char> packet, double time);
+
+    /**
+     * @brief simulates one input for every connected client, or all of theirs that arrived when input isn't buffered,
+     * then sends each of them a game update for their own character and a world snapshot of the characters near it,
+     * in client id order
+     * @param time when the tick started
+     */
+    void tick(float delta_time, double time, const SendFunction &send);
+
+    const ConnectedClient *find_client(unsigned int client_id) const;
+    size_t get_num_clients() const { return client_id_to_connected_client.size(); }
+
+  private:
+    /**
+     * @brief the tick's movement step when input isn't buffered, steps everyone once per input they drained, a client
+     * who drained fewer than the most sits out the remaining steps and one who drained nothing isn't moved at all, all
+     * on the calling thread since it's only ever run to compare against
+     */
+    void simulate_drained_inputs(float delta_time);
+
+    Settings settings;
+    JPH::PhysicsSystem &physics_system;
+    WorkStealingPool &pool;
+    // every worker needs its own, jolt's temp allocator is a stack and can't be shared between threads
+    std::vector<std::unique_ptr<JPH::TempAllocatorImpl>> worker_temp_allocators;
+
+    // unordered_map never moves its nodes, so a client's entry in connected_clients_in_order stays valid until they
+    // disconnect, which removes both
+    std::unordered_map<unsigned int, ConnectedClient> client_id_to_connected_client;
+    // kept sorted by client id so that every tick simulates and sends in the same order no matter the thread count
+    std::vector<ConnectedClient *> connected_clients_in_order;
+    // every character's velocity and input side by side, so one pass of the movement step covers everyone
+    CharacterMovementStore character_movement;
+
+    // reused every packet so decoding a batch doesn't allocate once it has grown to fit
+    std::vector<KeyboardUpdate> decoded_keyboard_updates;
+
+    // one new world snapshot per tick, every client gets their own view of it
+    int world_snapshot_id = 0;
+    // when each world snapshot went out, to time the acknowledgements
+    TickRingBuffer<double, 64> world_snapshot_send_times;
+    std::vector<CharacterSnapshot> all_characters;
+    std::vector<glm::vec2> all_character_positions;
+    SpatialGrid spatial_grid;
+    // scratch space for gathering each client's nearby characters, per worker so they can be gathered in parallel
+    std::vector<std::vector<unsigned int>> worker_nearby_ids;
+    std::vector<std::vector<CharacterSnapshot>> worker_nearby_characters;
+    // velocities of the clients sitting out a step of simulate_drained_inputs, put back after it
+    std::vector<glm::vec2> held_velocities;
+
+    // from sending a world snapshot to the tick that reads the first input batch acknowledging it, so on top of the
+    // network round trip it includes up to one client send interval and one tick
+    metrics::Histogram &round_trip_time_ms;
+    metrics::Counter &inputs_processed;
+    // ticks where the input hadn't arrived in time and the previous one was repeated instead, either it was lost in
+    // every batch that carried it or the jitter buffer was too shallow for how late it was
+    metrics::Counter &input_underruns;
+    // ticks a connected client's character stood still because their jitter buffer had nothing to hand out
+    metrics::Counter &ticks_without_input;
+    metrics::Histogram &input_buffer_depth_ticks;
+};
+
+#endif // SERVER_SIMULATION_HPP
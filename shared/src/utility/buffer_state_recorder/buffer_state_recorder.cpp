@@ -0,0 +1,29 @@
+#include "buffer_state_recorder.hpp"
+
+#include <cstring>
+
+BufferStateRecorder::BufferStateRecorder(uint8_t *data, size_t capacity, size_t size)
+    : data(data), capacity(capacity), size(size) {}
+
+void BufferStateRecorder::WriteBytes(const void *in_data, size_t num_bytes) {
+    if (failed or num_bytes > capacity - size) {
+        failed = true;
+        return;
+    }
+    std::memcpy(data + size, in_data, num_bytes);
+    size += num_bytes;
+}
+
+void BufferStateRecorder::ReadBytes(void *out_data, size_t num_bytes) {
+    if (failed or num_bytes > size - read_position) {
+        failed = true;
+        std::memset(out_data, 0, num_bytes);
+        return;
+    }
+    std::memcpy(out_data, data + read_position, num_bytes);
+    read_position += num_bytes;
+}
+
+bool BufferStateRecorder::IsEOF() const { return read_position >= size; }
+
+bool BufferStateRecorder::IsFailed() const { return failed; }
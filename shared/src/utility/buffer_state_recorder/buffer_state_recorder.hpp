@@ -0,0 +1,39 @@
+#ifndef BUFFER_STATE_RECORDER_HPP
+#define BUFFER_STATE_RECORDER_HPP
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/StateRecorder.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief a jolt state recorder that writes into and reads from memory owned by someone else, unlike
+ * JPH::StateRecorderImpl it never allocates so saving and restoring can happen every tick for free
+ *
+ * @note writing past the end of the buffer doesn't overrun it, the recorder just reports IsFailed and the state it
+ * holds should not be restored
+ */
+class BufferStateRecorder : public JPH::StateRecorder {
+  public:
+    /**
+     * @param size how many bytes of data already hold a saved state, 0 to start recording from scratch
+     */
+    BufferStateRecorder(uint8_t *data, size_t capacity, size_t size = 0);
+
+    void WriteBytes(const void *in_data, size_t num_bytes) override;
+    void ReadBytes(void *out_data, size_t num_bytes) override;
+    bool IsEOF() const override;
+    bool IsFailed() const override;
+
+    size_t get_size() const { return size; }
+
+  private:
+    uint8_t *data;
+    size_t capacity;
+    size_t size;
+    size_t read_position = 0;
+    bool failed = false;
+};
+
+#endif // BUFFER_STATE_RECORDER_HPP
@@ -0,0 +1,228 @@
+#include "capture.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../tracing/tracing.hpp"
+
+namespace capture {
+
+namespace {
+
+void append_record(char *destination, RecordType type, const void *data, size_t size) {
+    RecordHeader record_header{static_cast<uint32_t>(size), type, 0};
+    std::memcpy(destination, &record_header, sizeof(record_header));
+    std::memcpy(destination + sizeof(record_header), data, size);
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter(const std::string &path, const Settings &settings) : settings(settings) {
+    file_descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file_descriptor < 0) {
+        throw std::system_error(errno, std::generic_category(), "opening capture file " + path);
+    }
+
+    for (size_t i = 0; i < settings.num_preallocated_chunks; i++) {
+        free_chunks.push_back({std::make_unique<char[]>(settings.chunk_size), settings.chunk_size, 0});
+    }
+    current_chunk = std::move(free_chunks.back());
+    free_chunks.pop_back();
+    current_chunk_opened_at = std::chrono::steady_clock::now();
+
+    FileHeader file_header{};
+    std::memcpy(file_header.magic, file_magic, sizeof(file_magic));
+    file_header.version = file_version;
+    std::memcpy(current_chunk.data.get(), &file_header, sizeof(file_header));
+    current_chunk.size = sizeof(file_header);
+    num_bytes_written = sizeof(file_header);
+
+    writer_thread = std::thread(&CaptureWriter::writer_loop, this);
+}
+
+CaptureWriter::~CaptureWriter() {
+    hand_off_current_chunk();
+    {
+        std::lock_guard lock(chunks_mutex);
+        writer_running = false;
+    }
+    chunk_handed_off.notify_one();
+    writer_thread.join();
+    close(file_descriptor);
+}
+
+void CaptureWriter::begin_tick(uint64_t tick_id, double dt, double time) {
+    if (current_chunk.size > 0 and std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                                 current_chunk_opened_at)
+                                           .count() >= settings.max_chunk_age) {
+        hand_off_current_chunk();
+    }
+    TickRecord tick_record{tick_id, dt, time};
+    write(RecordType::tick, &tick_record, sizeof(tick_record));
+}
+
+void CaptureWriter::write(RecordType type, const void *data, size_t size) {
+    if (has_failed()) {
+        return;
+    }
+    size_t record_size = sizeof(RecordHeader) + size;
+    num_bytes_written += record_size;
+
+    // only happens for records bigger than a whole chunk, those go out in a chunk of their own
+    if (record_size > settings.chunk_size) {
+        hand_off_current_chunk();
+        Chunk oversized_chunk{std::make_unique<char[]>(record_size), record_size, record_size};
+        append_record(oversized_chunk.data.get(), type, data, size);
+        {
+            std::lock_guard lock(chunks_mutex);
+            full_chunks.push_back(std::move(oversized_chunk));
+        }
+        chunk_handed_off.notify_one();
+        return;
+    }
+
+    if (current_chunk.size + record_size > current_chunk.capacity) {
+        hand_off_current_chunk();
+    }
+    append_record(current_chunk.data.get() + current_chunk.size, type, data, size);
+    current_chunk.size += record_size;
+}
+
+void CaptureWriter::hand_off_current_chunk() {
+    if (current_chunk.size == 0) {
+        return;
+    }
+    {
+        std::lock_guard lock(chunks_mutex);
+        full_chunks.push_back(std::move(current_chunk));
+        if (free_chunks.empty()) {
+            current_chunk = {std::make_unique<char[]>(settings.chunk_size), settings.chunk_size, 0};
+        } else {
+            current_chunk = std::move(free_chunks.back());
+            free_chunks.pop_back();
+        }
+    }
+    chunk_handed_off.notify_one();
+    current_chunk_opened_at = std::chrono::steady_clock::now();
+}
+
+void CaptureWriter::writer_loop() {
+    std::unique_lock lock(chunks_mutex);
+    while (true) {
+        chunk_handed_off.wait(lock, [&] { return not full_chunks.empty() or not writer_running; });
+        if (full_chunks.empty()) {
+            return;
+        }
+        Chunk chunk = std::move(full_chunks.front());
+        full_chunks.pop_front();
+        lock.unlock();
+
+        size_t num_written = 0;
+        while (not has_failed() and num_written < chunk.size) {
+            ssize_t result = ::write(file_descriptor, chunk.data.get() + num_written, chunk.size - num_written);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // a full disk shouldn't take the session down with it, the capture just ends at the last chunk that
+                // made it out whole, chunks only ever hold whole records
+                TRACE_ERROR("capture stopped, writing it failed: {}", std::strerror(errno));
+                failed.store(true, std::memory_order_relaxed);
+                if (ftruncate(file_descriptor, static_cast<off_t>(num_bytes_on_disk)) < 0) {
+                    TRACE_ERROR("couldn't cut the partly written chunk off the capture: {}", std::strerror(errno));
+                }
+                break;
+            }
+            num_written += result;
+        }
+        if (not has_failed()) {
+            num_bytes_on_disk += chunk.size;
+        }
+
+        lock.lock();
+        chunk.size = 0;
+        // chunks made for a single oversized record aren't worth keeping around
+        if (chunk.capacity == settings.chunk_size) {
+            free_chunks.push_back(std::move(chunk));
+        }
+    }
+}
+
+CaptureReader::CaptureReader(const std::string &path) {
+    int file_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_descriptor < 0) {
+        throw std::system_error(errno, std::generic_category(), "opening capture file " + path);
+    }
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) < 0) {
+        int error = errno;
+        close(file_descriptor);
+        throw std::system_error(error, std::generic_category(), "reading the size of capture file " + path);
+    }
+    file_size = file_stat.st_size;
+    if (file_size < sizeof(FileHeader)) {
+        close(file_descriptor);
+        throw std::runtime_error(path + " is too short to be a capture file");
+    }
+    void *mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    // the mapping keeps the file alive on its own
+    close(file_descriptor);
+    if (mapping == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "mapping capture file " + path);
+    }
+    file_data = static_cast<const char *>(mapping);
+    // replays read it front to back exactly once
+    madvise(mapping, file_size, MADV_SEQUENTIAL);
+
+    FileHeader file_header;
+    std::memcpy(&file_header, file_data, sizeof(file_header));
+    if (std::memcmp(file_header.magic, file_magic, sizeof(file_magic)) != 0 or file_header.version != file_version) {
+        munmap(const_cast<char *>(file_data), file_size);
+        throw std::runtime_error(path + " is not a version " + std::to_string(file_version) + " capture file");
+    }
+    offset = sizeof(file_header);
+}
+
+CaptureReader::~CaptureReader() { munmap(const_cast<char *>(file_data), file_size); }
+
+std::optional<Record> CaptureReader::peek_record() const {
+    if (file_size - offset < sizeof(RecordHeader)) {
+        return std::nullopt;
+    }
+    RecordHeader record_header;
+    std::memcpy(&record_header, file_data + offset, sizeof(record_header));
+    // cut short by a crash partway through writing it
+    if (file_size - offset - sizeof(RecordHeader) < record_header.size) {
+        return std::nullopt;
+    }
+    return Record{record_header.type, file_data + offset + sizeof(RecordHeader), record_header.size};
+}
+
+std::optional<TickRecord> CaptureReader::read_tick(std::vector<Record> &records) {
+    records.clear();
+    // anything before the first tick record can't be attributed to a tick
+    std::optional<Record> record;
+    while ((record = peek_record()).has_value() and record->type != RecordType::tick) {
+        offset += sizeof(RecordHeader) + record->size;
+    }
+    if (not record.has_value() or record->size != sizeof(TickRecord)) {
+        return std::nullopt;
+    }
+    TickRecord tick_record;
+    std::memcpy(&tick_record, record->data, sizeof(tick_record));
+    offset += sizeof(RecordHeader) + record->size;
+
+    while ((record = peek_record()).has_value() and record->type != RecordType::tick) {
+        records.push_back(record.value());
+        offset += sizeof(RecordHeader) + record->size;
+    }
+    return tick_record;
+}
+
+} // namespace capture
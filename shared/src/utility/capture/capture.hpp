@@ -0,0 +1,169 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief records everything that comes into a session (packets, connects, local input) tick by tick into a binary
+ * file, so it can be fed back through the simulation later exactly as it arrived
+ *
+ * @note the file is a FileHeader followed by records, each a RecordHeader and then its payload, and is only ever
+ * appended to. Every tick starts with a tick record and everything up to the next one happened during that tick. A
+ * file cut short by a crash is still readable up to the last whole record.
+ */
+namespace capture {
+
+constexpr char file_magic[8] = {'c', 'p', 's', 'r', 'c', 'a', 'p', '\0'};
+constexpr uint32_t file_version = 2;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+enum class RecordType : uint16_t {
+    // payload is a TickRecord
+    tick = 0,
+    // payload is the packet's bytes as they came off the network, how the client records what the server sends it
+    received_packet = 1,
+    // payload is the uint32_t client id the server handed out
+    client_connected = 2,
+    // payload is the uint64_t of held keys and when they changed that the event thread published
+    local_input = 3,
+    // payload is the uint32_t client id of the connection the packet came in on followed by the packet's bytes, how
+    // the server records what clients send it
+    received_client_packet = 4,
+    // payload is the uint32_t client id of a connection that went away
+    client_disconnected = 5,
+};
+
+struct RecordHeader {
+    uint32_t size;
+    RecordType type;
+    uint16_t reserved;
+};
+
+struct TickRecord {
+    // counts up from zero, replays can tell a tick was dropped if this skips
+    uint64_t tick_id;
+    // what the tick was stepped by
+    double dt;
+    // when the tick started in seconds, on whichever clock the recording side stamps its input with
+    double time;
+};
+
+/**
+ * @brief appends records to a capture file, cheap enough to call for every packet on the tick hot path
+ *
+ * @note records are copied into the current chunk of a pool allocated up front, a full chunk is handed to a
+ * background thread which writes it to the file and gives it back, so recording is a memcpy and only takes a lock
+ * once per chunk. The pool only grows if the disk falls behind. A chunk that has been open for max_chunk_age is handed
+ * off at the next tick even if it isn't full, so a crash loses at most that much. Only call from one thread.
+ *
+ * The first write that fails ends the capture: whatever of the chunk made it out is cut off the file again so it ends
+ * on a whole record, and nothing recorded afterwards is written, even if the disk has room again by then.
+ */
+class CaptureWriter {
+  public:
+    struct Settings {
+        size_t chunk_size = 1 << 20;
+        size_t num_preallocated_chunks = 8;
+        double max_chunk_age = 1;
+    };
+
+    /**
+     * @brief creates or truncates the file at path, throws std::system_error if it can't be opened
+     */
+    explicit CaptureWriter(const std::string &path) : CaptureWriter(path, Settings{}) {}
+    CaptureWriter(const std::string &path, const Settings &settings);
+    // writes out everything recorded so far
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    void begin_tick(uint64_t tick_id, double dt, double time);
+    void write(RecordType type, const void *data, size_t size);
+
+    uint64_t get_num_bytes_written() const { return num_bytes_written; }
+    bool has_failed() const { return failed.load(std::memory_order_relaxed); }
+
+  private:
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t capacity = 0;
+        size_t size = 0;
+    };
+
+    void hand_off_current_chunk();
+    void writer_loop();
+
+    Settings settings;
+    int file_descriptor = -1;
+    // set by the writer thread, from then on records are dropped as they're made
+    std::atomic<bool> failed = false;
+    // where the last chunk that was written out whole ends, only touched by the writer thread
+    uint64_t num_bytes_on_disk = 0;
+
+    Chunk current_chunk;
+    std::chrono::steady_clock::time_point current_chunk_opened_at;
+    uint64_t num_bytes_written = 0;
+
+    std::mutex chunks_mutex;
+    std::condition_variable chunk_handed_off;
+    std::deque<Chunk> full_chunks;
+    std::vector<Chunk> free_chunks;
+    bool writer_running = true;
+    std::thread writer_thread;
+};
+
+struct Record {
+    RecordType type;
+    // points into the mapped file, valid as long as the reader is
+    const char *data;
+    size_t size;
+};
+
+/**
+ * @brief reads a capture file back by mapping it into memory, packets are handed out in place without copying
+ */
+class CaptureReader {
+  public:
+    /**
+     * @brief throws std::system_error if the file can't be mapped and std::runtime_error if it isn't a capture
+     */
+    explicit CaptureReader(const std::string &path);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    /**
+     * @brief the next tick and every record that came in during it, in the order they were recorded
+     * @return nothing once the file runs out
+     */
+    std::optional<TickRecord> read_tick(std::vector<Record> &records);
+
+  private:
+    std::optional<Record> peek_record() const;
+
+    const char *file_data = nullptr;
+    size_t file_size = 0;
+    size_t offset = 0;
+};
+
+} // namespace capture
+
+#endif // CAPTURE_HPP
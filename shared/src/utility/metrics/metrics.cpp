@@ -0,0 +1,297 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace metrics {
+
+namespace {
+
+std::atomic<size_t> next_thread_shard_index = 0;
+
+// metrics are only ever added, never removed, so an index into these names the same metric forever
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<Histogram>> histograms;
+std::vector<std::unique_ptr<Counter>> counters;
+
+std::thread exporter_thread;
+std::mutex exporter_mutex;
+std::condition_variable exporter_wake_up;
+bool exporter_running = false;
+
+/**
+ * @brief what one histogram looked like over one period
+ */
+struct HistogramSummary {
+    uint64_t count = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+    uint64_t total_count = 0;
+};
+
+struct CounterSummary {
+    uint64_t count = 0;
+    uint64_t total = 0;
+};
+
+HistogramSummary summarize(const std::array<uint64_t, Histogram::num_buckets> &period_bucket_counts,
+                           double period_sum, uint64_t total_count) {
+    HistogramSummary summary;
+    summary.total_count = total_count;
+    for (uint64_t bucket_count : period_bucket_counts) {
+        summary.count += bucket_count;
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean = period_sum / summary.count;
+
+    auto get_percentile = [&](double quantile) {
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * summary.count)));
+        uint64_t cumulative_count = 0;
+        for (size_t i = 0; i < Histogram::num_buckets; i++) {
+            cumulative_count += period_bucket_counts[i];
+            if (cumulative_count >= rank) {
+                return Histogram::get_bucket_upper_bound(i);
+            }
+        }
+        return Histogram::get_bucket_upper_bound(Histogram::num_buckets - 1);
+    };
+    summary.p50 = get_percentile(0.5);
+    summary.p90 = get_percentile(0.9);
+    summary.p99 = get_percentile(0.99);
+    summary.p999 = get_percentile(0.999);
+    summary.max = get_percentile(1);
+    return summary;
+}
+
+/**
+ * @brief sums up everything recorded since the last call and appends it to the csv and rewrites the json
+ */
+class Exporter {
+  public:
+    explicit Exporter(const ExportSettings &settings) : settings(settings) {
+        if (not settings.csv_path.empty()) {
+            csv.open(settings.csv_path, std::ios::app);
+            // a fresh file gets a header, an existing one is continued
+            if (csv.tellp() == 0) {
+                csv << "unix_time,metric,count,mean,p50,p90,p99,p999,max,total\n";
+            }
+        }
+    }
+
+    void export_period() {
+        double unix_time =
+            std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        histogram_summaries.clear();
+        counter_summaries.clear();
+        {
+            std::lock_guard lock(registry_mutex);
+            previous_histogram_bucket_counts.resize(histograms.size());
+            previous_histogram_sums.resize(histograms.size(), 0);
+            for (size_t i = 0; i < histograms.size(); i++) {
+                std::array<uint64_t, Histogram::num_buckets> bucket_counts{};
+                double sum = 0;
+                histograms[i]->sum_shards(bucket_counts, sum);
+
+                std::array<uint64_t, Histogram::num_buckets> period_bucket_counts;
+                uint64_t total_count = 0;
+                for (size_t bucket = 0; bucket < Histogram::num_buckets; bucket++) {
+                    period_bucket_counts[bucket] = bucket_counts[bucket] - previous_histogram_bucket_counts[i][bucket];
+                    total_count += bucket_counts[bucket];
+                }
+                histogram_summaries.emplace_back(histograms[i]->get_name(),
+                                                 summarize(period_bucket_counts, sum - previous_histogram_sums[i],
+                                                           total_count));
+                previous_histogram_bucket_counts[i] = bucket_counts;
+                previous_histogram_sums[i] = sum;
+            }
+
+            previous_counter_totals.resize(counters.size(), 0);
+            for (size_t i = 0; i < counters.size(); i++) {
+                uint64_t total = counters[i]->sum_shards();
+                counter_summaries.emplace_back(counters[i]->get_name(),
+                                               CounterSummary{total - previous_counter_totals[i], total});
+                previous_counter_totals[i] = total;
+            }
+        }
+
+        if (csv.is_open()) {
+            write_csv(unix_time);
+        }
+        if (not settings.json_path.empty()) {
+            write_json(unix_time);
+        }
+    }
+
+  private:
+    void write_csv(double unix_time) {
+        for (const auto &[name, summary] : histogram_summaries) {
+            csv << std::format("{:.3f},{},{},{},{},{},{},{},{},{}\n", unix_time, name, summary.count, summary.mean,
+                               summary.p50, summary.p90, summary.p99, summary.p999, summary.max, summary.total_count);
+        }
+        for (const auto &[name, summary] : counter_summaries) {
+            csv << std::format("{:.3f},{},{},,,,,,,{}\n", unix_time, name, summary.count, summary.total);
+        }
+        csv.flush();
+    }
+
+    void write_json(double unix_time) {
+        std::string json = std::format("{{\"unix_time\":{:.3f},\"period\":{},\"histograms\":{{", unix_time,
+                                       settings.period);
+        for (size_t i = 0; i < histogram_summaries.size(); i++) {
+            const auto &[name, summary] = histogram_summaries[i];
+            json += std::format("{}\"{}\":{{\"count\":{},\"mean\":{},\"p50\":{},\"p90\":{},\"p99\":{},\"p999\":{},"
+                                "\"max\":{},\"total\":{}}}",
+                                i == 0 ? "" : ",", name, summary.count, summary.mean, summary.p50, summary.p90,
+                                summary.p99, summary.p999, summary.max, summary.total_count);
+        }
+        json += "},\"counters\":{";
+        for (size_t i = 0; i < counter_summaries.size(); i++) {
+            const auto &[name, summary] = counter_summaries[i];
+            json += std::format("{}\"{}\":{{\"count\":{},\"total\":{}}}", i == 0 ? "" : ",", name, summary.count,
+                                summary.total);
+        }
+        json += "}}\n";
+
+        std::string temporary_path = settings.json_path + ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::trunc);
+            file << json;
+        }
+        std::rename(temporary_path.c_str(), settings.json_path.c_str());
+    }
+
+    ExportSettings settings;
+    std::ofstream csv;
+    std::vector<std::array<uint64_t, Histogram::num_buckets>> previous_histogram_bucket_counts;
+    std::vector<double> previous_histogram_sums;
+    std::vector<uint64_t> previous_counter_totals;
+    // reused every period
+    std::vector<std::pair<std::string, HistogramSummary>> histogram_summaries;
+    std::vector<std::pair<std::string, CounterSummary>> counter_summaries;
+};
+
+void exporter_loop(ExportSettings settings) {
+    Exporter exporter(settings);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(settings.period));
+    auto next_export = std::chrono::steady_clock::now() + period;
+    std::unique_lock lock(exporter_mutex);
+    while (exporter_running) {
+        if (exporter_wake_up.wait_until(lock, next_export, [] { return not exporter_running; })) {
+            break;
+        }
+        lock.unlock();
+        exporter.export_period();
+        lock.lock();
+        next_export += period;
+    }
+    lock.unlock();
+    exporter.export_period();
+}
+
+} // namespace
+
+namespace detail {
+
+size_t get_thread_shard_index() {
+    thread_local size_t thread_shard_index = next_thread_shard_index.fetch_add(1) % max_threads;
+    return thread_shard_index;
+}
+
+} // namespace detail
+
+Histogram::~Histogram() {
+    for (std::atomic<Shard *> &shard : shards) {
+        delete shard.load();
+    }
+}
+
+Histogram::Shard &Histogram::create_shard(size_t shard_index) {
+    Shard *new_shard = new Shard;
+    Shard *expected = nullptr;
+    // only loses when more than max_threads threads are recording and another one shares our index
+    if (not shards[shard_index].compare_exchange_strong(expected, new_shard, std::memory_order_acq_rel)) {
+        delete new_shard;
+        return *expected;
+    }
+    return *new_shard;
+}
+
+void Histogram::sum_shards(std::array<uint64_t, num_buckets> &bucket_counts, double &sum) const {
+    for (const std::atomic<Shard *> &atomic_shard : shards) {
+        const Shard *shard = atomic_shard.load(std::memory_order_acquire);
+        if (shard == nullptr) {
+            continue;
+        }
+        for (size_t i = 0; i < num_buckets; i++) {
+            bucket_counts[i] += shard->bucket_counts[i].load(std::memory_order_relaxed);
+        }
+        sum += shard->sum.load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t Counter::sum_shards() const {
+    uint64_t total = 0;
+    for (const Shard &shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram &get_histogram(const std::string &name) {
+    std::lock_guard lock(registry_mutex);
+    for (const std::unique_ptr<Histogram> &histogram : histograms) {
+        if (histogram->get_name() == name) {
+            return *histogram;
+        }
+    }
+    return *histograms.emplace_back(std::make_unique<Histogram>(name));
+}
+
+Counter &get_counter(const std::string &name) {
+    std::lock_guard lock(registry_mutex);
+    for (const std::unique_ptr<Counter> &counter : counters) {
+        if (counter->get_name() == name) {
+            return *counter;
+        }
+    }
+    return *counters.emplace_back(std::make_unique<Counter>(name));
+}
+
+void start_exporting(const ExportSettings &settings) {
+    std::lock_guard lock(exporter_mutex);
+    if (exporter_running) {
+        return;
+    }
+    exporter_running = true;
+    exporter_thread = std::thread(exporter_loop, settings);
+}
+
+void stop_exporting() {
+    {
+        std::lock_guard lock(exporter_mutex);
+        if (not exporter_running) {
+            return;
+        }
+        exporter_running = false;
+    }
+    exporter_wake_up.notify_all();
+    exporter_thread.join();
+}
+
+} // namespace metrics
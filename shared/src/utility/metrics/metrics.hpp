@@ -0,0 +1,169 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/**
+ * @brief counters and histograms that are cheap enough to update from the tick hot path on any thread, periodically
+ * summed up and written out by a background thread
+ *
+ * @note every thread updates its own shard of a metric with relaxed atomics, so recording never takes a lock and
+ * threads never fight over a cache line. Get metrics once up front with get_histogram and get_counter, those do take
+ * a lock, and hold on to the reference, metrics live until the program exits.
+ */
+namespace metrics {
+
+// threads beyond this share shards, which is still correct just slower
+constexpr size_t max_threads = 64;
+
+namespace detail {
+
+/**
+ * @brief which shard the calling thread records into, handed out the first time a thread records anything
+ */
+size_t get_thread_shard_index();
+
+} // namespace detail
+
+/**
+ * @brief a distribution of values, recording is a couple of atomic adds
+ *
+ * @note buckets are log linear, every power of two is split into sub_buckets_per_octave equal buckets, so a
+ * percentile is reported as the upper bound of its bucket and is at most an eighth above the true value. Values at or
+ * below zero share the lowest bucket and values past the largest bucket are counted in it.
+ */
+class Histogram {
+  public:
+    static constexpr int sub_buckets_per_octave = 8;
+    // everything under 2^-16 (15ns when recording milliseconds) lands in the lowest bucket, the largest octave ends
+    // at 2^24
+    static constexpr int min_exponent = -16;
+    static constexpr int max_exponent = 24;
+    static constexpr size_t num_buckets = (max_exponent - min_exponent) * sub_buckets_per_octave + 1;
+
+    explicit Histogram(std::string name) : name(std::move(name)) {}
+    ~Histogram();
+
+    void record(double value) {
+        Shard &shard = get_shard(detail::get_thread_shard_index());
+        shard.bucket_counts[get_bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static size_t get_bucket_index(double value) {
+        if (not(value > 0)) {
+            return 0;
+        }
+        // value is mantissa * 2^exponent with the mantissa in [0.5, 1)
+        int exponent;
+        double mantissa = std::frexp(value, &exponent);
+        if (exponent <= min_exponent) {
+            return 0;
+        }
+        if (exponent > max_exponent) {
+            return num_buckets - 1;
+        }
+        int sub_bucket = static_cast<int>((mantissa - 0.5) * 2 * sub_buckets_per_octave);
+        return (exponent - min_exponent - 1) * sub_buckets_per_octave + sub_bucket + 1;
+    }
+
+    static double get_bucket_upper_bound(size_t bucket_index) {
+        if (bucket_index == 0) {
+            return std::ldexp(1.0, min_exponent);
+        }
+        int exponent = static_cast<int>((bucket_index - 1) / sub_buckets_per_octave) + min_exponent + 1;
+        int sub_bucket = static_cast<int>((bucket_index - 1) % sub_buckets_per_octave);
+        return std::ldexp(0.5 + 0.5 * (sub_bucket + 1) / sub_buckets_per_octave, exponent);
+    }
+
+    const std::string &get_name() const { return name; }
+
+    /**
+     * @brief adds every shard's counts into bucket_counts and sum, safe to call while other threads are recording
+     */
+    void sum_shards(std::array<uint64_t, num_buckets> &bucket_counts, double &sum) const;
+
+  private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, num_buckets> bucket_counts{};
+        std::atomic<double> sum = 0;
+    };
+
+    Shard &get_shard(size_t shard_index) {
+        Shard *shard = shards[shard_index].load(std::memory_order_acquire);
+        return shard != nullptr ? *shard : create_shard(shard_index);
+    }
+
+    // shards are only allocated for threads that actually record into this histogram
+    Shard &create_shard(size_t shard_index);
+
+    std::string name;
+    std::array<std::atomic<Shard *>, max_threads> shards{};
+};
+
+/**
+ * @brief a running total, like packets lost or mispredictions
+ */
+class Counter {
+  public:
+    explicit Counter(std::string name) : name(std::move(name)) {}
+
+    void add(uint64_t amount = 1) {
+        shards[detail::get_thread_shard_index()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    const std::string &get_name() const { return name; }
+
+    uint64_t sum_shards() const;
+
+  private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    std::string name;
+    std::array<Shard, max_threads> shards;
+};
+
+/**
+ * @brief the histogram with this name, created the first time it's asked for
+ * @note names are written into the csv and json as they are, so stick to letters, digits and underscores and put the
+ * unit at the end, like tick_duration_ms
+ */
+Histogram &get_histogram(const std::string &name);
+
+/**
+ * @brief the counter with this name, created the first time it's asked for
+ */
+Counter &get_counter(const std::string &name);
+
+struct ExportSettings {
+    // one row per metric per period is appended here, so it holds the whole history
+    std::string csv_path;
+    // replaced every period with only the newest period, written to a temporary file and renamed over the old one so
+    // anything scraping it never sees half a file
+    std::string json_path;
+    double period = 1;
+};
+
+/**
+ * @brief starts the thread which every period sums up what was recorded since the last one and writes it out
+ * @note histograms are reported per period (count, mean, p50, p90, p99, p999, max), counters as the amount added in
+ * the period along with the running total
+ */
+void start_exporting(const ExportSettings &settings);
+
+/**
+ * @brief writes out the last partial period and stops the background thread
+ */
+void stop_exporting();
+
+} // namespace metrics
+
+#endif // METRICS_HPP
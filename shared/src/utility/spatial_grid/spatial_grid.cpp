@@ -0,0 +1,47 @@
+#include "spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float cell_size) : cell_size(cell_size) {}
+
+void SpatialGrid::rebuild(std::span<const glm::vec2> positions) {
+    points_sorted_by_cell.clear();
+    for (unsigned int id = 0; id < positions.size(); id++) {
+        points_sorted_by_cell.push_back({get_cell_key(get_cell(positions[id])), id, positions[id]});
+    }
+    // ties broken by id so the order within a cell doesn't depend on the sort
+    std::sort(points_sorted_by_cell.begin(), points_sorted_by_cell.end(), [](const Point &a, const Point &b) {
+        return a.cell_key != b.cell_key ? a.cell_key < b.cell_key : a.id < b.id;
+    });
+}
+
+void SpatialGrid::query(glm::vec2 center, float radius, std::vector<unsigned int> &ids_within_radius) const {
+    glm::ivec2 min_cell = get_cell(center - glm::vec2(radius));
+    glm::ivec2 max_cell = get_cell(center + glm::vec2(radius));
+    float radius_squared = radius * radius;
+
+    for (int x = min_cell.x; x <= max_cell.x; x++) {
+        for (int y = min_cell.y; y <= max_cell.y; y++) {
+            uint64_t cell_key = get_cell_key(glm::ivec2(x, y));
+            auto cell_begin = std::lower_bound(
+                points_sorted_by_cell.begin(), points_sorted_by_cell.end(), cell_key,
+                [](const Point &point, uint64_t cell_key) { return point.cell_key < cell_key; });
+            for (auto it = cell_begin; it != points_sorted_by_cell.end() and it->cell_key == cell_key; it++) {
+                glm::vec2 offset = it->position - center;
+                if (offset.x * offset.x + offset.y * offset.y <= radius_squared) {
+                    ids_within_radius.push_back(it->id);
+                }
+            }
+        }
+    }
+}
+
+glm::ivec2 SpatialGrid::get_cell(glm::vec2 position) const {
+    return glm::ivec2(static_cast<int>(std::floor(position.x / cell_size)),
+                      static_cast<int>(std::floor(position.y / cell_size)));
+}
+
+uint64_t SpatialGrid::get_cell_key(glm::ivec2 cell) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32) | static_cast<uint32_t>(cell.y);
+}
@@ -0,0 +1,48 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief buckets points into square cells so that finding everything near a point only looks at the cells around it
+ * instead of at every point
+ *
+ * @note it's meant to be rebuilt from scratch every tick, which is cheaper than tracking movement when nearly
+ * everything moves. The points are kept sorted by cell in one array so a rebuild doesn't allocate once it has grown
+ * and queries always return ids in the same order
+ */
+class SpatialGrid {
+  public:
+    explicit SpatialGrid(float cell_size);
+
+    /**
+     * @brief replaces everything in the grid, a point's id is its index in positions
+     */
+    void rebuild(std::span<const glm::vec2> positions);
+
+    /**
+     * @brief appends the id of every point within radius of center to ids_within_radius
+     *
+     * @note only reads the grid, so any number of threads can query at once as long as nobody is rebuilding
+     */
+    void query(glm::vec2 center, float radius, std::vector<unsigned int> &ids_within_radius) const;
+
+  private:
+    struct Point {
+        uint64_t cell_key;
+        unsigned int id;
+        glm::vec2 position;
+    };
+
+    glm::ivec2 get_cell(glm::vec2 position) const;
+    static uint64_t get_cell_key(glm::ivec2 cell);
+
+    float cell_size;
+    std::vector<Point> points_sorted_by_cell;
+};
+
+#endif // SPATIAL_GRID_HPP
@@ -0,0 +1,91 @@
+#ifndef TICK_RING_BUFFER_HPP
+#define TICK_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+/**
+ * @brief a fixed amount of per tick data stored by tick id, the slot for an id is id % capacity so lookups are a
+ * single index and the memory never grows no matter how long the session runs
+ *
+ * @note ids must be non negative. Once an id has been discarded it can't be inserted again until the buffer is cleared,
+ * and inserting an id a full capacity ahead of the oldest live one evicts the oldest ones to make room.
+ */
+template <typename T, size_t capacity> class TickRingBuffer {
+    static_assert(capacity > 0 and (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    /**
+     * @return the stored value, or nullptr if the id was already discarded
+     */
+    T *insert(int id, const T &value) {
+        if (id < lowest_live_id) {
+            return nullptr;
+        }
+        if (static_cast<size_t>(id - lowest_live_id) >= capacity) {
+            discard_up_to_and_including(id - static_cast<int>(capacity));
+        }
+        Slot &slot = slots[slot_index(id)];
+        slot.id = id;
+        slot.occupied = true;
+        slot.value = value;
+        return &slot.value;
+    }
+
+    T *find(int id) {
+        if (id < lowest_live_id) {
+            return nullptr;
+        }
+        Slot &slot = slots[slot_index(id)];
+        return slot.occupied and slot.id == id ? &slot.value : nullptr;
+    }
+
+    const T *find(int id) const { return const_cast<TickRingBuffer *>(this)->find(id); }
+
+    bool contains(int id) const { return find(id) != nullptr; }
+
+    /**
+     * @brief frees every id up to and including the given one, only walks the slots that can actually be live so it
+     * costs at most one pass over the buffer however far the id jumps
+     */
+    void discard_up_to_and_including(int id) {
+        if (id < lowest_live_id) {
+            return;
+        }
+        size_t num_to_clear = std::min(static_cast<size_t>(id - lowest_live_id) + 1, capacity);
+        for (size_t i = 0; i < num_to_clear; i++) {
+            Slot &slot = slots[slot_index(lowest_live_id + static_cast<int>(i))];
+            if (slot.id <= id) {
+                slot.occupied = false;
+            }
+        }
+        lowest_live_id = id + 1;
+    }
+
+    /**
+     * @brief frees every id, after which any id can be inserted again
+     */
+    void clear() {
+        for (Slot &slot : slots) {
+            slot.occupied = false;
+        }
+        lowest_live_id = 0;
+    }
+
+    int get_lowest_live_id() const { return lowest_live_id; }
+
+  private:
+    struct Slot {
+        int id = -1;
+        bool occupied = false;
+        T value;
+    };
+
+    static size_t slot_index(int id) { return static_cast<size_t>(id) & (capacity - 1); }
+
+    std::array<Slot, capacity> slots;
+    int lowest_live_id = 0;
+};
+
+#endif // TICK_RING_BUFFER_HPP
@@ -0,0 +1,163 @@
+#include "tracing.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace tracing {
+
+namespace {
+
+/**
+ * @brief bounded multi producer queue where every cell carries a sequence number saying whose turn it is, producers
+ * and the consumer only ever contend on a single atomic each (Vyukov's design)
+ */
+class RecordQueue {
+  public:
+    explicit RecordQueue(size_t capacity) : cells(new Cell[capacity]), mask(capacity - 1) {
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(const Record &record) {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        cell->record = record;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(Record &record) {
+        size_t position = dequeue_position.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+        record = cell->record;
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_position = 0;
+    alignas(64) std::atomic<size_t> dequeue_position = 0;
+};
+
+// a few seconds of everything at the trace level, must be a power of two
+constexpr size_t record_queue_capacity = 1 << 14;
+
+RecordQueue record_queue(record_queue_capacity);
+std::atomic<uint64_t> num_dropped_records = 0;
+
+std::shared_ptr<spdlog::logger> logger;
+std::thread writer_thread;
+std::atomic<bool> writer_running = false;
+
+spdlog::level::level_enum to_spdlog_level(Level level) {
+    switch (level) {
+    case Level::trace:
+        return spdlog::level::trace;
+    case Level::debug:
+        return spdlog::level::debug;
+    case Level::info:
+        return spdlog::level::info;
+    case Level::warn:
+        return spdlog::level::warn;
+    case Level::error:
+        return spdlog::level::err;
+    default:
+        return spdlog::level::off;
+    }
+}
+
+void write_queued_records(std::string &text) {
+    Record record;
+    while (record_queue.try_pop(record)) {
+        record.format(record, text);
+        logger->log(record.time, spdlog::source_loc{}, to_spdlog_level(record.level), text);
+    }
+}
+
+void writer_loop() {
+    std::string text;
+    while (writer_running.load(std::memory_order_relaxed)) {
+        write_queued_records(text);
+        // nothing waits on the writer, so polling a few hundred times a second keeps up without any signalling
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    write_queued_records(text);
+    logger->flush();
+}
+
+} // namespace
+
+void start_tracing(const std::vector<spdlog::sink_ptr> &sinks) {
+    if (writer_running) {
+        return;
+    }
+    logger = std::make_shared<spdlog::logger>("tracing", sinks.begin(), sinks.end());
+    // the sinks decide what they show, the logger lets everything that was compiled in through
+    logger->set_level(spdlog::level::trace);
+    writer_running = true;
+    writer_thread = std::thread(writer_loop);
+}
+
+void stop_tracing() {
+    if (not writer_running) {
+        return;
+    }
+    writer_running = false;
+    writer_thread.join();
+    if (num_dropped_records > 0) {
+        logger->warn("tracing dropped {} records because the queue was full", num_dropped_records.load());
+    }
+}
+
+uint64_t get_num_dropped_records() { return num_dropped_records.load(std::memory_order_relaxed); }
+
+namespace detail {
+
+bool try_push(const Record &record) {
+    if (record_queue.try_push(record)) {
+        return true;
+    }
+    num_dropped_records.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+} // namespace detail
+
+} // namespace tracing
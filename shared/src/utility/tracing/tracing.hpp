@@ -0,0 +1,127 @@
+#ifndef TRACING_HPP
+#define TRACING_HPP
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief levelled logging that is cheap enough for the tick hot path
+ *
+ * @note use it through the TRACE_* macros. A level below CPSR_TRACE_LEVEL compiles to nothing, its arguments are not
+ * even evaluated. An enabled level copies its arguments into a slot of a lock free queue and returns, the formatting
+ * and the write to the spdlog sinks happen on a background thread. Arguments that can't be copied safely (strings,
+ * pointers) or don't fit in a slot are formatted on the spot instead, still without allocating.
+ */
+namespace tracing {
+
+enum class Level : uint8_t {
+    trace = 0,
+    debug = 1,
+    info = 2,
+    warn = 3,
+    error = 4,
+    off = 5,
+};
+
+#ifndef CPSR_TRACE_LEVEL
+#define CPSR_TRACE_LEVEL 1
+#endif
+
+constexpr Level compiled_level = static_cast<Level>(CPSR_TRACE_LEVEL);
+
+/**
+ * @brief starts the thread which writes queued records to the given sinks, records made before this are kept as long
+ * as the queue has room
+ */
+void start_tracing(const std::vector<spdlog::sink_ptr> &sinks);
+
+/**
+ * @brief writes out whatever is still queued and stops the background thread
+ */
+void stop_tracing();
+
+/**
+ * @brief how many records were thrown away because the queue was full, the hot path never waits for the writer
+ */
+uint64_t get_num_dropped_records();
+
+constexpr size_t max_record_payload_size = 128;
+
+struct Record {
+    Level level;
+    std::chrono::system_clock::time_point time;
+    void (*format)(const Record &record, std::string &out);
+    // only used when the arguments are stored and formatted later
+    const char *format_string;
+    // only used when the payload already holds the formatted text
+    size_t payload_size;
+    alignas(std::max_align_t) std::array<std::byte, max_record_payload_size> payload;
+};
+
+namespace detail {
+
+bool try_push(const Record &record);
+
+template <typename T> constexpr bool is_deferrable = std::is_trivially_copyable_v<T> and not std::is_pointer_v<T>;
+
+template <typename... Args> void format_deferred(const Record &record, std::string &out) {
+    const auto &arguments = *std::launder(reinterpret_cast<const std::tuple<Args...> *>(record.payload.data()));
+    std::apply([&](const auto &...args) { out = std::vformat(record.format_string, std::make_format_args(args...)); },
+               arguments);
+}
+
+inline void format_preformatted(const Record &record, std::string &out) {
+    out.assign(reinterpret_cast<const char *>(record.payload.data()), record.payload_size);
+}
+
+template <Level level, typename... Args>
+void record(std::format_string<Args...> checked_format_string, const char *format_string, Args &&...args) {
+    Record record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+
+    using Arguments = std::tuple<std::decay_t<Args>...>;
+    if constexpr ((is_deferrable<std::decay_t<Args>> and ...) and sizeof(Arguments) <= max_record_payload_size and
+                  alignof(Arguments) <= alignof(std::max_align_t)) {
+        static_assert(std::is_trivially_destructible_v<Arguments>);
+        new (record.payload.data()) Arguments(std::forward<Args>(args)...);
+        record.format = &format_deferred<std::decay_t<Args>...>;
+        record.format_string = format_string;
+    } else {
+        auto result = std::format_to_n(reinterpret_cast<char *>(record.payload.data()), max_record_payload_size,
+                                       checked_format_string, std::forward<Args>(args)...);
+        record.payload_size = std::min<size_t>(result.size, max_record_payload_size);
+        record.format = &format_preformatted;
+    }
+    try_push(record);
+}
+
+} // namespace detail
+
+} // namespace tracing
+
+// the format string is passed twice, once to be checked at compile time and once to be kept for the writer thread
+#define CPSR_TRACE(level, format_string, ...)                                                                          \
+    do {                                                                                                               \
+        if constexpr (level >= tracing::compiled_level) {                                                              \
+            tracing::detail::record<level>(format_string, format_string __VA_OPT__(, ) __VA_ARGS__);                   \
+        }                                                                                                              \
+    } while (0)
+
+#define TRACE_TRACE(...) CPSR_TRACE(tracing::Level::trace, __VA_ARGS__)
+#define TRACE_DEBUG(...) CPSR_TRACE(tracing::Level::debug, __VA_ARGS__)
+#define TRACE_INFO(...) CPSR_TRACE(tracing::Level::info, __VA_ARGS__)
+#define TRACE_WARN(...) CPSR_TRACE(tracing::Level::warn, __VA_ARGS__)
+#define TRACE_ERROR(...) CPSR_TRACE(tracing::Level::error, __VA_ARGS__)
+
+#endif // TRACING_HPP
@@ -0,0 +1,119 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(unsigned int num_workers) : num_workers(std::max(1u, num_workers)) {
+    for (unsigned int i = 0; i < this->num_workers; i++) {
+        worker_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned int worker_index = 1; worker_index < this->num_workers; worker_index++) {
+        threads.emplace_back(&WorkStealingPool::worker_loop, this, worker_index);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex);
+        stopping = true;
+    }
+    batch_started.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::parallel_for(size_t count, const std::function<void(size_t, unsigned int)> &task,
+                                    size_t grain_size) {
+    if (count == 0) {
+        return;
+    }
+
+    if (num_workers == 1) {
+        for (size_t i = 0; i < count; i++) {
+            task(i, 0);
+        }
+        return;
+    }
+
+    grain_size = std::max<size_t>(1, grain_size);
+    current_task = &task;
+    remaining_items = count;
+
+    // deal the chunks out round robin so every worker starts with a fair share and only steals at the tail end
+    unsigned int worker_index = 0;
+    for (size_t begin = 0; begin < count; begin += grain_size) {
+        WorkerQueue &queue = *worker_queues[worker_index];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.ranges.push_back({begin, std::min(count, begin + grain_size)});
+        }
+        worker_index = (worker_index + 1) % num_workers;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex);
+        batch_generation++;
+    }
+    batch_started.notify_all();
+
+    work_until_batch_is_done(0);
+
+    std::unique_lock<std::mutex> lock(batch_mutex);
+    batch_finished.wait(lock, [&] { return remaining_items == 0; });
+    current_task = nullptr;
+}
+
+bool WorkStealingPool::try_pop_local(unsigned int worker_index, Range &range) {
+    WorkerQueue &queue = *worker_queues[worker_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) {
+        return false;
+    }
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::try_steal(unsigned int worker_index, Range &range) {
+    for (unsigned int offset = 1; offset < num_workers; offset++) {
+        WorkerQueue &victim = *worker_queues[(worker_index + offset) % num_workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (not victim.ranges.empty()) {
+            // take from the opposite end to the owner so we rarely fight over the same chunk
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work_until_batch_is_done(unsigned int worker_index) {
+    Range range;
+    while (try_pop_local(worker_index, range) or try_steal(worker_index, range)) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            (*current_task)(i, worker_index);
+        }
+        size_t range_size = range.end - range.begin;
+        if (remaining_items.fetch_sub(range_size) == range_size) {
+            // take the lock so the notify can't slip in between the waiter checking and going to sleep
+            std::lock_guard<std::mutex> lock(batch_mutex);
+            batch_finished.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::worker_loop(unsigned int worker_index) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(batch_mutex);
+            batch_started.wait(lock, [&] { return stopping or batch_generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = batch_generation;
+        }
+        work_until_batch_is_done(worker_index);
+    }
+}
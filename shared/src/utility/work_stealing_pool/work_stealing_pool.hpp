@@ -0,0 +1,69 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief a fixed set of threads which split a range of work between them, every worker starts with its own share of
+ * the range and once it runs out it steals from the others, so one slow item doesn't hold everyone else up
+ *
+ * @note the thread calling parallel_for is worker 0 and does work too, so a pool of 1 worker spawns no threads and
+ * runs everything inline
+ */
+class WorkStealingPool {
+  public:
+    explicit WorkStealingPool(unsigned int num_workers = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    unsigned int get_num_workers() const { return num_workers; }
+
+    /**
+     * @brief calls task(index, worker_index) for every index in [0, count) and returns once they are all done,
+     * worker_index is in [0, get_num_workers()) and lets the task use per worker scratch space without locking
+     *
+     * @param grain_size how many consecutive indices are handed out at once, raise it when a single task is tiny
+     */
+    void parallel_for(size_t count, const std::function<void(size_t, unsigned int)> &task, size_t grain_size = 1);
+
+  private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    bool try_pop_local(unsigned int worker_index, Range &range);
+    bool try_steal(unsigned int worker_index, Range &range);
+    void work_until_batch_is_done(unsigned int worker_index);
+    void worker_loop(unsigned int worker_index);
+
+    unsigned int num_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> worker_queues;
+    std::vector<std::thread> threads;
+
+    const std::function<void(size_t, unsigned int)> *current_task = nullptr;
+    std::atomic<size_t> remaining_items = 0;
+
+    std::mutex batch_mutex;
+    std::condition_variable batch_started;
+    std::condition_variable batch_finished;
+    uint64_t batch_generation = 0;
+    bool stopping = false;
+};
+
+#endif // WORK_STEALING_POOL_HPP
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/character_update/character_update.hpp"
+
+namespace {
+
+struct alignas(16) SimdVec3 {
+    float x;
+    float y;
+    float z;
+    float w;
+};
+
+/**
+ * @brief stands in for a JPH::CharacterVirtual, a heap object of a few hundred bytes with its velocity somewhere in
+ * the middle, behind accessors that aren't inlined since they live in a separately compiled library
+ */
+struct PhysicsCharacter {
+    char before_velocity[256];
+    SimdVec3 velocity{};
+    char after_velocity[336];
+
+    __attribute__((noinline)) SimdVec3 GetLinearVelocity() const { return velocity; }
+    __attribute__((noinline)) void SetLinearVelocity(SimdVec3 new_velocity) { velocity = new_velocity; }
+};
+
+// what the server used to keep per client, the velocity was read back from here when snapshots were gathered
+struct OldConnectedClient {
+    unsigned int client_id;
+    PhysicsCharacter *character;
+    glm::vec2 current_velocity;
+    char everything_else[200];
+};
+
+/**
+ * @brief the old per character step, process_keyboard_update without the collision update, which is the same call
+ * either way
+ */
+glm::vec2 old_step(PhysicsCharacter &character, const KeyboardUpdate &keyboard_update, float delta_time) {
+    glm::vec3 acceleration = glm::vec3(get_input_vector(keyboard_update), 0) * character_acceleration * delta_time;
+    SimdVec3 velocity = character.GetLinearVelocity();
+    SimdVec3 new_velocity{(velocity.x + acceleration.x) * character_friction,
+                          (velocity.y + acceleration.y) * character_friction,
+                          (velocity.z + acceleration.z) * character_friction, 0};
+    character.SetLinearVelocity(new_velocity);
+    return glm::vec2(new_velocity.x, new_velocity.y);
+}
+
+struct StepTimes {
+    // per character per tick, setting the input, stepping and reading the velocity back
+    double old_seconds;
+    double store_seconds;
+    // per character per tick, only step_character_velocities
+    double kernel_seconds;
+};
+
+StepTimes time_steps(size_t num_characters, unsigned int num_ticks) {
+    const float delta_time = 1.0f / 60;
+    std::mt19937_64 random_engine(5);
+
+    // allocated and then walked in a shuffled order, so neighbours in the client list aren't neighbours in memory,
+    // like on a server that has been up for a while
+    std::vector<std::unique_ptr<PhysicsCharacter>> characters;
+    for (size_t i = 0; i < num_characters; i++) {
+        characters.push_back(std::make_unique<PhysicsCharacter>());
+    }
+    std::shuffle(characters.begin(), characters.end(), random_engine);
+    std::vector<std::unique_ptr<OldConnectedClient>> clients;
+    for (size_t i = 0; i < num_characters; i++) {
+        clients.push_back(std::make_unique<OldConnectedClient>(
+            OldConnectedClient{static_cast<unsigned int>(i), characters[i].get(), glm::vec2(0), {}}));
+    }
+    std::shuffle(clients.begin(), clients.end(), random_engine);
+    std::vector<OldConnectedClient *> clients_in_order;
+    for (const std::unique_ptr<OldConnectedClient> &client : clients) {
+        clients_in_order.push_back(client.get());
+    }
+    std::sort(clients_in_order.begin(), clients_in_order.end(),
+              [](const OldConnectedClient *a, const OldConnectedClient *b) { return a->client_id < b->client_id; });
+
+    CharacterMovementStore character_movement;
+    std::vector<size_t> movement_indices;
+    for (size_t i = 0; i < num_characters; i++) {
+        movement_indices.push_back(character_movement.add());
+    }
+
+    // a handful of ticks of random input cycled through, generating it every tick would cost more than stepping
+    const unsigned int num_input_sets = 16;
+    std::vector<std::vector<KeyboardUpdate>> input_sets(num_input_sets);
+    std::uniform_int_distribution<int> held_keys(0, 15);
+    for (unsigned int set = 0; set < num_input_sets; set++) {
+        for (size_t i = 0; i < num_characters; i++) {
+            int held = held_keys(random_engine);
+            input_sets[set].push_back(KeyboardUpdate(static_cast<unsigned int>(i), static_cast<int>(set), held & 1,
+                                                     held & 2, held & 4, held & 8));
+        }
+    }
+
+    // read so the compiler can't drop the velocities, the snapshot gather reads every one of them back too
+    volatile float velocity_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        const std::vector<KeyboardUpdate> &inputs = input_sets[tick % num_input_sets];
+        for (size_t i = 0; i < num_characters; i++) {
+            clients_in_order[i]->current_velocity = old_step(*clients_in_order[i]->character, inputs[i], delta_time);
+        }
+        float sum = 0;
+        for (size_t i = 0; i < num_characters; i++) {
+            sum += clients_in_order[i]->current_velocity.x;
+        }
+        velocity_sum = velocity_sum + sum;
+    }
+    auto old_done = std::chrono::steady_clock::now();
+
+    double kernel_seconds = 0;
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        const std::vector<KeyboardUpdate> &inputs = input_sets[tick % num_input_sets];
+        for (size_t i = 0; i < num_characters; i++) {
+            character_movement.set_input(movement_indices[i], inputs[i]);
+        }
+        auto kernel_start = std::chrono::steady_clock::now();
+        step_character_velocities(character_movement, delta_time);
+        kernel_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - kernel_start).count();
+        float sum = 0;
+        for (size_t i = 0; i < num_characters; i++) {
+            sum += character_movement.get_velocity(movement_indices[i]).x;
+        }
+        velocity_sum = velocity_sum + sum;
+    }
+    auto store_done = std::chrono::steady_clock::now();
+
+    double num_steps = static_cast<double>(num_ticks) * num_characters;
+    return {std::chrono::duration<double>(old_done - start).count() / num_steps,
+            std::chrono::duration<double>(store_done - old_done).count() / num_steps, kernel_seconds / num_steps};
+}
+
+} // namespace
+
+/**
+ * @brief the velocity step with characters kept in a CharacterMovementStore against the old way of stepping each
+ * connected client's physics character through its accessors, at 1000 to 100000 characters
+ *
+ * @note the characters are stand ins rather than CharacterVirtuals so this runs without a physics system, they have
+ * about the same size and accessors that can't be inlined, and the collision update, the same call either way, is
+ * left out
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        std::cout << "usage: " << argv[0] << " [num_ticks]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 500;
+
+    for (size_t num_characters : {1000u, 10000u, 50000u, 100000u}) {
+        StepTimes step_times = time_steps(num_characters, num_ticks);
+        std::cout << std::format("{:>6} characters: per character old {:>6.2f}ns store {:>6.2f}ns of which stepping "
+                                 "{:>5.2f}ns, {:.1f}x\n",
+                                 num_characters, 1e9 * step_times.old_seconds, 1e9 * step_times.store_seconds,
+                                 1e9 * step_times.kernel_seconds, step_times.old_seconds / step_times.store_seconds);
+    }
+    return 0;
+}
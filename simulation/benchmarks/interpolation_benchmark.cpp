@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "networking/messages/messages.hpp"
+#include "networking/remote_character_interpolator/remote_character_interpolator.hpp"
+#include "networking/simulated_link/simulated_link.hpp"
+
+namespace {
+
+const double snapshot_period = 1.0 / 60;
+const double frame_period = 1.0 / 144;
+const unsigned int remote_client_id = 7;
+
+// a remote character walking a smooth loop, its velocity is the derivative so extrapolation has something to go on
+glm::vec2 true_position(double time) {
+    return {static_cast<float>(3 * std::sin(0.9 * time) + std::sin(2.3 * time)),
+            static_cast<float>(2 * std::cos(0.6 * time))};
+}
+
+glm::vec2 true_velocity(double time) {
+    return {static_cast<float>(2.7 * std::cos(0.9 * time) + 2.3 * std::cos(2.3 * time)),
+            static_cast<float>(-1.2 * std::sin(0.6 * time))};
+}
+
+struct VisualError {
+    double rms;
+    double p99;
+    // the share of frames where the character didn't move at all
+    double frozen_fraction;
+    // the constant delay the drawn positions fit the true path best at
+    double delay;
+};
+
+/**
+ * @brief scores positions drawn at frame_times against the true path, any way of drawing remote characters shows them
+ * some time in the past so each is compared against the path delayed by whichever constant delay suits it best, what's
+ * left is the error a player sees as stutter rather than as latency
+ */
+VisualError score(const std::vector<double> &frame_times, const std::vector<glm::vec2> &drawn_positions) {
+    std::vector<double> best_errors;
+    double best_squared_error = 0;
+    double best_delay = 0;
+    for (double delay = 0; delay < 0.3; delay += 0.0005) {
+        std::vector<double> errors;
+        double squared_error = 0;
+        for (size_t frame = 0; frame < frame_times.size(); frame++) {
+            errors.push_back(glm::length(drawn_positions[frame] - true_position(frame_times[frame] - delay)));
+            squared_error += errors.back() * errors.back();
+        }
+        if (best_errors.empty() or squared_error < best_squared_error) {
+            best_errors = std::move(errors);
+            best_squared_error = squared_error;
+            best_delay = delay;
+        }
+    }
+
+    unsigned int num_frozen_frames = 0;
+    for (size_t frame = 1; frame < drawn_positions.size(); frame++) {
+        num_frozen_frames += glm::length(drawn_positions[frame] - drawn_positions[frame - 1]) == 0;
+    }
+    std::sort(best_errors.begin(), best_errors.end());
+    return {std::sqrt(best_squared_error / best_errors.size()),
+            best_errors[static_cast<size_t>(0.99 * (best_errors.size() - 1))],
+            static_cast<double>(num_frozen_frames) / drawn_positions.size(), best_delay};
+}
+
+/**
+ * @brief sends a snapshot of the remote character every tick over a lossy link for duration seconds and records where
+ * it's drawn every frame, both interpolated and snapped to the newest snapshot like the client used to
+ */
+void measure_visual_error(double loss, double duration) {
+    LinkSettings link_settings;
+    link_settings.latency = 0.05;
+    link_settings.jitter = 0.01;
+    link_settings.loss = loss;
+    SimulatedLink link(link_settings, 42);
+    RemoteCharacterInterpolator interpolator({});
+    std::vector<RemoteCharacterInterpolator::RemoteCharacter> remote_characters;
+
+    int next_snapshot_id = 1;
+    int newest_snapshot_id = 0;
+    glm::vec2 newest_position(0);
+    std::vector<double> frame_times;
+    std::vector<glm::vec2> interpolated_positions;
+    std::vector<glm::vec2> snapped_positions;
+    WorldSnapshot world_snapshot;
+    for (double time = 0; time < duration; time += frame_period) {
+        for (; next_snapshot_id * snapshot_period <= time; next_snapshot_id++) {
+            double server_time = next_snapshot_id * snapshot_period;
+            glm::vec2 position = true_position(server_time);
+            glm::vec2 velocity = true_velocity(server_time);
+            WorldSnapshot sent{next_snapshot_id,
+                               {{remote_client_id, wire_format::to_fixed_point(position.x),
+                                 wire_format::to_fixed_point(position.y), wire_format::to_fixed_point(velocity.x),
+                                 wire_format::to_fixed_point(velocity.y)}}};
+            wire_format::EncodedMessage message = wire_format::encode_world_snapshot(sent, nullptr);
+            link.send(message.data.data(), message.size, server_time);
+        }
+        for (const std::vector<char> &packet : link.receive(time)) {
+            if (not wire_format::decode_world_snapshot(packet.data(), packet.size(), nullptr, world_snapshot) or
+                world_snapshot.id <= newest_snapshot_id) {
+                continue;
+            }
+            newest_snapshot_id = world_snapshot.id;
+            interpolator.add_world_snapshot(world_snapshot, world_snapshot.id * snapshot_period, time);
+            const CharacterSnapshot &character = world_snapshot.characters[0];
+            newest_position = {static_cast<float>(wire_format::from_fixed_point(character.position_x)),
+                               static_cast<float>(wire_format::from_fixed_point(character.position_y))};
+        }
+
+        // the first couple of seconds let the clock offset settle
+        interpolator.sample(time, remote_characters);
+        if (time < 2 or remote_characters.empty()) {
+            continue;
+        }
+        frame_times.push_back(time);
+        interpolated_positions.push_back(remote_characters[0].position);
+        snapped_positions.push_back(newest_position);
+    }
+
+    for (auto [name, positions] : {std::pair{"snapped to newest", &snapped_positions},
+                                   {"interpolated", &interpolated_positions}}) {
+        VisualError error = score(frame_times, *positions);
+        std::cout << std::format("loss {:>2.0f}% {:<17}: error rms {:.4f} p99 {:.4f}, {:>4.1f}% of frames frozen, "
+                                 "best fit delay {:.1f}ms\n",
+                                 100 * loss, name, error.rms, error.p99, 100 * error.frozen_fraction,
+                                 1000 * error.delay);
+    }
+}
+
+/**
+ * @brief how long sampling every character takes per frame, with two frames drawn per snapshot like at 144Hz
+ */
+double time_sampling(unsigned int num_characters, unsigned int num_snapshots) {
+    RemoteCharacterInterpolator interpolator({});
+    std::vector<RemoteCharacterInterpolator::RemoteCharacter> remote_characters;
+    WorldSnapshot world_snapshot;
+    double sample_seconds = 0;
+    unsigned int num_frames = 0;
+    for (int id = 1; id <= static_cast<int>(num_snapshots); id++) {
+        world_snapshot.id = id;
+        world_snapshot.characters.clear();
+        for (unsigned int client_id = 0; client_id < num_characters; client_id++) {
+            world_snapshot.characters.push_back({client_id, id * 10 + static_cast<int32_t>(client_id),
+                                                 static_cast<int32_t>(client_id), 5, 0});
+        }
+        double server_time = id * snapshot_period;
+        interpolator.add_world_snapshot(world_snapshot, server_time, server_time + 0.05);
+        for (int frame = 0; frame < 2; frame++) {
+            double local_time = server_time + 0.05 + frame * frame_period;
+            auto start = std::chrono::steady_clock::now();
+            interpolator.sample(local_time, remote_characters);
+            sample_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            num_frames++;
+        }
+    }
+    return sample_seconds / num_frames;
+}
+
+} // namespace
+
+/**
+ * @brief how far from its true path a remote character is drawn at 0%, 5% and 20% loss, interpolated against snapped
+ * to the newest snapshot like the client used to, and what sampling costs per frame at 100, 1000 and 10000 characters
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 3) {
+        std::cout << "usage: " << argv[0] << " [seconds_per_loss_rate] [num_snapshots]" << std::endl;
+        return 1;
+    }
+    double duration = argc > 1 ? std::stod(argv[1]) : 120;
+    unsigned int num_snapshots = argc > 2 ? std::stoul(argv[2]) : 600;
+
+    for (double loss : {0.0, 0.05, 0.2}) {
+        measure_visual_error(loss, duration);
+    }
+    for (unsigned int num_characters : {100u, 1000u, 10000u}) {
+        double sample_seconds = time_sampling(num_characters, num_snapshots);
+        std::cout << std::format("{:>5} characters: {:.1f}us per frame to sample, {:.1f}ns each\n", num_characters,
+                                 1e6 * sample_seconds, 1e9 * sample_seconds / num_characters);
+    }
+    return 0;
+}
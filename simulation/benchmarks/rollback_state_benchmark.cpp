@@ -0,0 +1,80 @@
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/TempAllocator.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "system_logic/character_update/character_update.hpp"
+#include "system_logic/client_simulation/client_simulation.hpp"
+#include "system_logic/physics/physics.hpp"
+#include "utility/buffer_state_recorder/buffer_state_recorder.hpp"
+
+/**
+ * @brief times saving and restoring a character's full jolt state the way ClientSimulation does every predicted tick
+ * and every replay, next to one predicted tick for scale, since the save is paid on every tick it has to stay a small
+ * fraction of that
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        std::cout << "usage: " << argv[0] << " [num_iterations]" << std::endl;
+        return 1;
+    }
+    unsigned int num_iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    Physics physics;
+    physics.create_character(0);
+    JPH::CharacterVirtual &character = *physics.client_id_to_physics_character[0];
+    JPH::TempAllocatorImpl temp_allocator(1024 * 1024);
+    CharacterMovementStore character_movement;
+    size_t movement_index = character_movement.add();
+    KeyboardUpdate held_input{0, 0};
+    held_input.forward_pressed = true;
+    held_input.right_pressed = true;
+    character_movement.set_input(movement_index, held_input);
+
+    const float delta_time = 1.0f / 60;
+    auto predict = [&]() {
+        step_character_velocities(character_movement, delta_time);
+        move_character(physics.physics_system, character, character_movement, movement_index, delta_time,
+                       temp_allocator);
+    };
+    // get it moving so the saved state is a typical one rather than a character that has never been stepped
+    for (int tick = 0; tick < 60; tick++) {
+        predict();
+    }
+
+    std::array<uint8_t, ClientSimulation::max_character_state_size> character_state;
+    size_t character_state_size = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < num_iterations; i++) {
+        BufferStateRecorder recorder(character_state.data(), character_state.size());
+        character.SaveState(recorder);
+        character_state_size = recorder.get_size();
+    }
+    double save_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < num_iterations; i++) {
+        BufferStateRecorder recorder(character_state.data(), character_state.size(), character_state_size);
+        character.RestoreState(recorder);
+    }
+    double restore_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // stepping is far slower than saving, a tenth of the iterations is plenty to time it
+    unsigned int num_predicted_ticks = std::max(1u, num_iterations / 10);
+    start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < num_predicted_ticks; i++) {
+        predict();
+    }
+    double predict_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::format("character state: {} bytes\n", character_state_size);
+    std::cout << std::format("save: {:.1f}ns restore: {:.1f}ns predicted tick: {:.1f}ns\n",
+                             1e9 * save_seconds / num_iterations, 1e9 * restore_seconds / num_iterations,
+                             1e9 * predict_seconds / num_predicted_ticks);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <Jolt/Jolt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/physics/physics.hpp"
+#include "system_logic/server_simulation/server_simulation.hpp"
+#include "utility/work_stealing_pool/work_stealing_pool.hpp"
+
+namespace {
+
+struct TickTimes {
+    double mean;
+    double p99;
+};
+
+/**
+ * @brief connects num_characters clients spread out on a grid, then ticks the server num_ticks times with every
+ * client sending one input per tick, only the ticks themselves are timed
+ */
+TickTimes time_server_ticks(unsigned int num_characters, unsigned int num_threads, unsigned int num_ticks) {
+    Physics physics;
+    WorkStealingPool pool(num_threads);
+    const double tick_period = 1.0 / 60;
+    ServerSimulation server({tick_period}, physics.physics_system, pool);
+
+    // five apart puts about a dozen characters in each other's interest radius
+    const float spacing = 5;
+    unsigned int grid_width = static_cast<unsigned int>(std::ceil(std::sqrt(num_characters)));
+    for (unsigned int client_id = 0; client_id < num_characters; client_id++) {
+        physics.create_character(client_id);
+        JPH::Ref<JPH::CharacterVirtual> character = physics.client_id_to_physics_character[client_id];
+        character->SetPosition(
+            JPH::Vec3(spacing * (client_id % grid_width), spacing * (client_id / grid_width), 0));
+        server.connect_client(client_id, character);
+    }
+
+    std::mt19937_64 random_engine(0);
+    std::bernoulli_distribution change_input(0.05);
+    std::bernoulli_distribution key_pressed(0.5);
+    std::vector<KeyboardUpdate> held_inputs(num_characters);
+    for (unsigned int client_id = 0; client_id < num_characters; client_id++) {
+        held_inputs[client_id].client_id = client_id;
+    }
+
+    std::vector<double> tick_seconds;
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        double now = tick * tick_period;
+        for (KeyboardUpdate &held_input : held_inputs) {
+            if (change_input(random_engine)) {
+                held_input.forward_pressed = key_pressed(random_engine);
+                held_input.backwards_pressed = key_pressed(random_engine);
+                held_input.left_pressed = key_pressed(random_engine);
+                held_input.right_pressed = key_pressed(random_engine);
+            }
+            held_input.id = static_cast<int>(tick);
+            // acknowledging the snapshot from a 100ms round trip ago, as a client in steady state would, snapshot ids
+            // start at 1 on the first tick
+            wire_format::EncodedMessage message = wire_format::encode_keyboard_update_batch(
+                held_input.client_id, std::span<const KeyboardUpdate>(&held_input, 1), static_cast<int>(tick) - 5);
+            server.receive_packet(held_input.client_id, std::span<const char>(message.data.data(), message.size),
+                                  now);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        server.tick(static_cast<float>(tick_period), now, [](unsigned int, const wire_format::EncodedMessage &) {});
+        tick_seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // the first second fills the jitter buffers and the world replication baselines, it isn't the steady state
+    tick_seconds.erase(tick_seconds.begin(), tick_seconds.begin() + std::min<size_t>(60, tick_seconds.size() / 2));
+    double total = 0;
+    for (double seconds : tick_seconds) {
+        total += seconds;
+    }
+    std::sort(tick_seconds.begin(), tick_seconds.end());
+    return {total / tick_seconds.size(), tick_seconds[static_cast<size_t>(0.99 * (tick_seconds.size() - 1))]};
+}
+
+} // namespace
+
+/**
+ * @brief how long a server tick takes against how many characters it steps and how many threads it steps them on,
+ * ideally tick time falls linearly with threads up to the core count
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 1 and std::string(argv[1]) == "--help") {
+        std::cout << "usage: " << argv[0] << " [num_ticks] [num_threads...]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 600;
+    std::vector<unsigned int> thread_counts;
+    for (int i = 2; i < argc; i++) {
+        thread_counts.push_back(std::stoul(argv[i]));
+    }
+    if (thread_counts.empty()) {
+        for (unsigned int num_threads = 1; num_threads < std::thread::hardware_concurrency(); num_threads *= 2) {
+            thread_counts.push_back(num_threads);
+        }
+        thread_counts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    std::cout << std::format("{} ticks per run, {} hardware threads\n", num_ticks, std::thread::hardware_concurrency());
+    for (unsigned int num_characters : {100u, 1000u, 10000u}) {
+        // speedups are relative to the first thread count
+        double baseline_mean = 0;
+        for (unsigned int num_threads : thread_counts) {
+            TickTimes tick_times = time_server_ticks(num_characters, num_threads, num_ticks);
+            if (baseline_mean == 0) {
+                baseline_mean = tick_times.mean;
+            }
+            std::cout << std::format("{:>6} characters {:>3} threads: mean {:.3f}ms p99 {:.3f}ms, {:.2f}x\n",
+                                     num_characters, num_threads, 1000 * tick_times.mean, 1000 * tick_times.p99,
+                                     baseline_mean / tick_times.mean);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include <glm/glm.hpp>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/client_simulation/client_simulation.hpp"
+#include "utility/tick_ring_buffer/tick_ring_buffer.hpp"
+
+namespace {
+
+// the same size and shape as what ClientSimulation keeps per tick
+struct TickSnapshot {
+    KeyboardUpdate input;
+    double made_at = 0;
+    glm::vec2 position = glm::vec2(0);
+    glm::vec2 velocity = glm::vec2(0);
+    std::array<uint8_t, ClientSimulation::max_character_state_size> character_state;
+    size_t character_state_size = 0;
+};
+
+// lookups are timed this many at a time, a clock read costs about as much as a lookup
+constexpr unsigned int lookups_per_sample = 1024;
+
+double resident_megabytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t num_pages = 0;
+    size_t num_resident_pages = 0;
+    statm >> num_pages >> num_resident_pages;
+    return static_cast<double>(num_resident_pages * sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+}
+
+/**
+ * @brief inserts one tick at a time and looks up the one a round trip ago, as reconciling does, printing the resident
+ * set size and lookup times every report_interval ticks
+ *
+ * @param tick called with the id to insert and the acknowledged id, which is negative for the first round trip,
+ * returns whether the acknowledged id was found
+ */
+template <typename Tick>
+void soak(const std::string &name, unsigned int num_ticks, unsigned int report_interval, Tick &&tick) {
+    const int round_trip_ticks = 6;
+    std::vector<double> lookup_ns;
+    unsigned int num_missing = 0;
+    std::cout << std::format("{}: {:.1f}MB resident before\n", name, resident_megabytes());
+    for (unsigned int first_id = 0; first_id < num_ticks; first_id += lookups_per_sample) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < lookups_per_sample; i++) {
+            int id = static_cast<int>(first_id + i);
+            num_missing += not tick(id, id - round_trip_ticks);
+        }
+        lookup_ns.push_back(1e9 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() /
+                            lookups_per_sample);
+
+        unsigned int num_ticks_done = first_id + lookups_per_sample;
+        if (num_ticks_done % report_interval < lookups_per_sample) {
+            std::sort(lookup_ns.begin(), lookup_ns.end());
+            std::cout << std::format("{}: {:>9} ticks {:>8.1f}MB resident, per tick p50 {:.1f}ns p99 {:.1f}ns "
+                                     "max {:.1f}ns\n",
+                                     name, num_ticks_done, resident_megabytes(), lookup_ns[lookup_ns.size() / 2],
+                                     lookup_ns[static_cast<size_t>(0.99 * (lookup_ns.size() - 1))], lookup_ns.back());
+            lookup_ns.clear();
+        }
+    }
+    if (num_missing > 0) {
+        std::cout << std::format("{}: {} acknowledged ids weren't found\n", name, num_missing);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief runs the per tick bookkeeping reconciliation does for millions of ticks, once with the ring of tick
+ * snapshots the client keeps now and once with the maps it used to keep, which were never pruned, and shows how
+ * resident memory and lookup time hold up
+ *
+ * @note the client makes an input, and so a snapshot, 60 times a second, so the default of two million ticks is over
+ * nine hours. Timings are per tick, a tick being one insert, one lookup and for the ring one discard.
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        std::cout << "usage: " << argv[0] << " [num_ticks]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    unsigned int report_interval = std::max(lookups_per_sample, num_ticks / 10);
+
+    // on the heap like the client's, a few hundred snapshots of a couple of kilobytes is too much for the stack
+    auto tick_snapshots = std::make_unique<TickRingBuffer<TickSnapshot, 256>>();
+    TickSnapshot tick_snapshot{};
+    soak("ring", num_ticks, report_interval, [&](int id, int acknowledged_id) {
+        tick_snapshot.input.id = id;
+        tick_snapshots->insert(id, tick_snapshot);
+        if (acknowledged_id < 0) {
+            return true;
+        }
+        const TickSnapshot *acknowledged = tick_snapshots->find(acknowledged_id);
+        // replay starts after the acknowledged id, so it and everything before it is freed
+        tick_snapshots->discard_up_to_and_including(acknowledged_id);
+        return acknowledged != nullptr and acknowledged->input.id == acknowledged_id;
+    });
+    tick_snapshots.reset();
+
+    // what the client used to keep, one entry per tick for as long as it ran
+    std::unordered_map<int, glm::vec2> id_to_position;
+    std::unordered_map<int, KeyboardUpdate> id_to_keyboard_update;
+    soak("old maps", num_ticks, report_interval, [&](int id, int acknowledged_id) {
+        id_to_position[id] = glm::vec2(0);
+        id_to_keyboard_update[id] = KeyboardUpdate{0, id};
+        if (acknowledged_id < 0) {
+            return true;
+        }
+        auto it = id_to_position.find(acknowledged_id);
+        return it != id_to_position.end() and id_to_keyboard_update.contains(acknowledged_id);
+    });
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <spdlog/sinks/basic_file_sink.h>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utility/tracing/tracing.hpp"
+
+static_assert(tracing::compiled_level == tracing::Level::debug,
+              "trace has to be compiled out and debug compiled in for the comparison to mean anything");
+
+namespace {
+
+// what both main.cpps used to do with every message, printing_active only ever skipped the write
+bool printing_active = false;
+void p(const std::string &s) {
+    if (printing_active) {
+        std::cout << s << std::endl;
+    }
+}
+
+#define OLD_P(...) p(std::format(__VA_ARGS__))
+
+// about what a tick used to log: its start and end, the input, the position before and after, the packets it read
+// and the id it processed
+#define LOG_TICK(LOG, tick, x, y, dt)                                                                                  \
+    do {                                                                                                               \
+        LOG("tick {} started", tick);                                                                                  \
+        LOG("input vector: ({}, {})", x, y);                                                                           \
+        LOG("position before: ({}, {})", x, y);                                                                        \
+        LOG("received packet of {} bytes", 17);                                                                        \
+        LOG("received packet of {} bytes", 42);                                                                        \
+        LOG("processing id: {} for client: {}", tick, 3);                                                              \
+        LOG("position after: ({}, {}) with dt: {}", x + dt, y - dt, dt);                                               \
+        LOG("tick {} took {}ms", tick, 1000 * dt);                                                                     \
+    } while (0)
+
+struct TickTimes {
+    double mean;
+    double p99;
+};
+
+/**
+ * @brief times log_tick once per tick, the ticks are spaced out like real ones so the background writer keeps up the
+ * way it would in a running server instead of the queue filling and records being dropped
+ */
+template <typename LogTick> TickTimes time_ticks(unsigned int num_ticks, LogTick &&log_tick) {
+    std::vector<double> tick_seconds;
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        float x = 0.25f * tick;
+        float y = -0.5f * tick;
+        float dt = 1.0f / 60;
+        auto start = std::chrono::steady_clock::now();
+        log_tick(tick, x, y, dt);
+        tick_seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double total = 0;
+    for (double seconds : tick_seconds) {
+        total += seconds;
+    }
+    std::sort(tick_seconds.begin(), tick_seconds.end());
+    return {total / tick_seconds.size(), tick_seconds[static_cast<size_t>(0.99 * (tick_seconds.size() - 1))]};
+}
+
+} // namespace
+
+/**
+ * @brief what the logging in a tick costs the tick: tracing compiled out, tracing on and handed to the background
+ * writer, and the old p(std::format(...)) with printing off and on
+ *
+ * @note the old printing writes to /dev/null rather than the terminal, so its numbers are the best it could do
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 3) {
+        std::cout << "usage: " << argv[0] << " [num_ticks] [log_path]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 2000;
+    std::string log_path = argc > 2 ? argv[2] : "tracing_benchmark.log";
+
+    tracing::start_tracing({std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_path, true)});
+    TickTimes compiled_out = time_ticks(num_ticks, [](unsigned int tick, float x, float y, float dt) {
+        LOG_TICK(TRACE_TRACE, tick, x, y, dt);
+    });
+    TickTimes traced = time_ticks(num_ticks, [](unsigned int tick, float x, float y, float dt) {
+        LOG_TICK(TRACE_DEBUG, tick, x, y, dt);
+    });
+    tracing::stop_tracing();
+
+    TickTimes old_not_printing =
+        time_ticks(num_ticks, [](unsigned int tick, float x, float y, float dt) { LOG_TICK(OLD_P, tick, x, y, dt); });
+    std::ofstream dev_null("/dev/null");
+    std::streambuf *stdout_buffer = std::cout.rdbuf(dev_null.rdbuf());
+    printing_active = true;
+    TickTimes old_printing =
+        time_ticks(num_ticks, [](unsigned int tick, float x, float y, float dt) { LOG_TICK(OLD_P, tick, x, y, dt); });
+    std::cout.rdbuf(stdout_buffer);
+
+    std::cout << std::format("{} ticks of 8 messages each, {} records dropped\n", num_ticks,
+                             tracing::get_num_dropped_records());
+    for (auto [name, tick_times] : {std::pair{"tracing compiled out", compiled_out}, {"tracing on", traced},
+                                    {"old, printing off", old_not_printing}, {"old, printing on", old_printing}}) {
+        std::cout << std::format("{:<21} mean {:>8.1f}ns p99 {:>8.1f}ns per tick\n", name, 1e9 * tick_times.mean,
+                                 1e9 * tick_times.p99);
+    }
+    return 0;
+}
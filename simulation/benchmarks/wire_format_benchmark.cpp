@@ -0,0 +1,143 @@
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/character_update/character_update.hpp"
+
+namespace {
+
+// what went on the wire before there was a wire format, the structs were memcpy'd into the packet as they were
+struct RawGameUpdate {
+    double position_x;
+    double position_y;
+    double velocity_x;
+    double velocity_y;
+    int last_id_used_to_produce_this_update;
+};
+
+struct RawKeyboardUpdate {
+    int id;
+    bool forward_pressed = false;
+    bool backwards_pressed = false;
+    bool left_pressed = false;
+    bool right_pressed = false;
+};
+
+} // namespace
+
+/**
+ * @brief encodes the game updates and input of a character walking around on seeded input and compares how many
+ * bytes they take against the raw structs that used to be sent, and how long encoding and decoding them takes
+ *
+ * @note the old client sent one packet per input, the new one sends everything unacknowledged in one batch, so the
+ * batch is measured at the window a given round trip leaves unacknowledged
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 3) {
+        std::cout << "usage: " << argv[0] << " [num_ticks] [round_trip_ticks]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 60 * 60 * 10;
+    unsigned int round_trip_ticks = argc > 2 ? std::stoul(argv[2]) : 6;
+
+    std::mt19937_64 random_engine(0);
+    std::bernoulli_distribution change_input(0.05);
+    std::bernoulli_distribution key_pressed(0.5);
+    std::normal_distribution<double> input_lead(0, 1);
+    CharacterMovementStore character_movement;
+    size_t movement_index = character_movement.add();
+    const float delta_time = 1.0f / 60;
+    glm::vec2 position(0);
+
+    std::vector<GameUpdate> game_updates;
+    std::vector<KeyboardUpdate> keyboard_updates;
+    KeyboardUpdate held_input{3, 0};
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        if (change_input(random_engine)) {
+            held_input.forward_pressed = key_pressed(random_engine);
+            held_input.backwards_pressed = key_pressed(random_engine);
+            held_input.left_pressed = key_pressed(random_engine);
+            held_input.right_pressed = key_pressed(random_engine);
+        }
+        held_input.id = static_cast<int>(tick);
+        keyboard_updates.push_back(held_input);
+        character_movement.set_input(movement_index, held_input);
+        step_character_velocities(character_movement, delta_time);
+        glm::vec2 velocity = character_movement.get_velocity(movement_index);
+        position += velocity * delta_time;
+        game_updates.push_back({position.x, position.y, velocity.x, velocity.y, static_cast<int>(tick),
+                                input_lead(random_engine)});
+    }
+
+    // only the encoded bytes are kept, copying whole EncodedMessages around would cost more than encoding them
+    std::vector<char> encoded_game_updates;
+    std::vector<size_t> encoded_game_update_ends;
+    // an encoded game update is never bigger than the raw one
+    encoded_game_updates.reserve(num_ticks * sizeof(RawGameUpdate));
+    auto start = std::chrono::steady_clock::now();
+    for (const GameUpdate &game_update : game_updates) {
+        wire_format::EncodedMessage message = wire_format::encode(game_update);
+        encoded_game_updates.insert(encoded_game_updates.end(), message.data.data(),
+                                    message.data.data() + message.size);
+        encoded_game_update_ends.push_back(encoded_game_updates.size());
+    }
+    double game_update_encode_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned int num_decoded = 0;
+    size_t message_start = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t message_end : encoded_game_update_ends) {
+        num_decoded += wire_format::decode_game_update(encoded_game_updates.data() + message_start,
+                                                       message_end - message_start)
+                           .has_value();
+        message_start = message_end;
+    }
+    double game_update_decode_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t game_update_bytes = encoded_game_updates.size();
+
+    // each tick sends the newest input along with the ones from the last round trip that aren't acknowledged yet
+    std::vector<KeyboardUpdate> decoded_keyboard_updates;
+    uint64_t batch_bytes = 0;
+    double batch_encode_seconds = 0;
+    double batch_decode_seconds = 0;
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        unsigned int first_unacknowledged = tick + 1 > round_trip_ticks ? tick + 1 - round_trip_ticks : 0;
+        std::span<const KeyboardUpdate> window(keyboard_updates.data() + first_unacknowledged,
+                                               keyboard_updates.data() + tick + 1);
+        start = std::chrono::steady_clock::now();
+        wire_format::EncodedMessage message =
+            wire_format::encode_keyboard_update_batch(3, window, static_cast<int>(tick) - 1);
+        auto encoded = std::chrono::steady_clock::now();
+        int acknowledged_world_snapshot_id;
+        num_decoded += wire_format::decode_keyboard_update_batch(message.data.data(), message.size,
+                                                                 decoded_keyboard_updates,
+                                                                 acknowledged_world_snapshot_id);
+        auto decoded = std::chrono::steady_clock::now();
+        batch_encode_seconds += std::chrono::duration<double>(encoded - start).count();
+        batch_decode_seconds += std::chrono::duration<double>(decoded - encoded).count();
+        batch_bytes += message.size;
+    }
+    if (num_decoded != 2 * num_ticks) {
+        std::cout << "some messages didn't decode" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::format("{} ticks, {} tick round trip\n", num_ticks, round_trip_ticks);
+    std::cout << std::format("game update: {:.1f} bytes vs {} raw, encode {:.1f}ns decode {:.1f}ns\n",
+                             static_cast<double>(game_update_bytes) / num_ticks, sizeof(RawGameUpdate),
+                             1e9 * game_update_encode_seconds / num_ticks,
+                             1e9 * game_update_decode_seconds / num_ticks);
+    std::cout << std::format("input: {:.1f} bytes per tick in one batch vs {} raw in one packet per input, "
+                             "encode {:.1f}ns decode {:.1f}ns\n",
+                             static_cast<double>(batch_bytes) / num_ticks, sizeof(RawKeyboardUpdate),
+                             1e9 * batch_encode_seconds / num_ticks, 1e9 * batch_decode_seconds / num_ticks);
+    std::cout << std::format("client id assignment: {} bytes vs {} raw\n",
+                             wire_format::encode(ClientIdAssignment{3}).size, sizeof(unsigned int));
+    return 0;
+}
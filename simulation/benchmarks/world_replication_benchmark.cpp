@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "networking/messages/messages.hpp"
+#include "networking/world_replication/world_replication.hpp"
+#include "utility/spatial_grid/spatial_grid.hpp"
+
+namespace {
+
+const float world_size = 100;
+// the server's default
+const float interest_radius = 10;
+const double tick_period = 1.0 / 60;
+
+struct ReplicationResult {
+    // per client per second
+    double delta_bits;
+    double full_snapshot_bits;
+    double everything_bits;
+    // gathering and encoding for every client, per tick
+    double encode_seconds;
+};
+
+/**
+ * @brief moves num_entities characters around a square world for num_ticks and encodes a world snapshot for each of
+ * them every tick the way the server does, acknowledgements come back a round trip after a snapshot was sent
+ *
+ * @param moving_fraction how many of them are walking, the rest stand still
+ */
+ReplicationResult replicate(unsigned int num_entities, double moving_fraction, unsigned int num_ticks,
+                            unsigned int round_trip_ticks) {
+    std::mt19937_64 random_engine(num_entities);
+    std::uniform_real_distribution<float> position_distribution(0, world_size);
+    std::uniform_real_distribution<float> velocity_distribution(-2, 2);
+    std::uniform_real_distribution<double> unit_distribution(0, 1);
+
+    std::vector<glm::vec2> positions(num_entities);
+    std::vector<glm::vec2> velocities(num_entities, glm::vec2(0));
+    for (unsigned int id = 0; id < num_entities; id++) {
+        positions[id] = {position_distribution(random_engine), position_distribution(random_engine)};
+        if (unit_distribution(random_engine) < moving_fraction) {
+            velocities[id] = {velocity_distribution(random_engine), velocity_distribution(random_engine)};
+        }
+    }
+
+    std::vector<WorldReplication> world_replications(num_entities);
+    // what the first snapshot would cost without deltas, these never see an acknowledgement
+    std::vector<WorldReplication> unacknowledged_world_replications(num_entities);
+    // the acknowledgements on their way back to the server, as the tick they arrive and the snapshot id
+    std::vector<std::deque<std::pair<unsigned int, int>>> acknowledgements_in_flight(num_entities);
+
+    SpatialGrid spatial_grid(interest_radius);
+    std::vector<CharacterSnapshot> all_characters;
+    std::vector<unsigned int> nearby_ids;
+    std::vector<CharacterSnapshot> nearby_characters;
+    uint64_t delta_bytes = 0;
+    uint64_t full_snapshot_bytes = 0;
+    double encode_seconds = 0;
+    for (unsigned int tick = 1; tick <= num_ticks; tick++) {
+        for (unsigned int id = 0; id < num_entities; id++) {
+            if (velocities[id] != glm::vec2(0) and unit_distribution(random_engine) < 0.02) {
+                velocities[id] = {velocity_distribution(random_engine), velocity_distribution(random_engine)};
+            }
+            positions[id] += velocities[id] * static_cast<float>(tick_period);
+            for (int axis = 0; axis < 2; axis++) {
+                if (positions[id][axis] < 0 or positions[id][axis] > world_size) {
+                    velocities[id][axis] = -velocities[id][axis];
+                }
+            }
+        }
+        for (unsigned int id = 0; id < num_entities; id++) {
+            std::deque<std::pair<unsigned int, int>> &in_flight = acknowledgements_in_flight[id];
+            while (not in_flight.empty() and in_flight.front().first <= tick) {
+                world_replications[id].acknowledge(in_flight.front().second);
+                in_flight.pop_front();
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        all_characters.clear();
+        for (unsigned int id = 0; id < num_entities; id++) {
+            all_characters.push_back({id, wire_format::to_fixed_point(positions[id].x),
+                                      wire_format::to_fixed_point(positions[id].y),
+                                      wire_format::to_fixed_point(velocities[id].x),
+                                      wire_format::to_fixed_point(velocities[id].y)});
+        }
+        spatial_grid.rebuild(positions);
+        for (unsigned int id = 0; id < num_entities; id++) {
+            nearby_characters.clear();
+            gather_nearby_characters(spatial_grid, all_characters, positions[id], interest_radius, id, nearby_ids,
+                                     nearby_characters);
+            delta_bytes +=
+                world_replications[id].encode_next_snapshot(static_cast<int>(tick), nearby_characters).size;
+            acknowledgements_in_flight[id].push_back({tick + round_trip_ticks, static_cast<int>(tick)});
+        }
+        encode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (unsigned int id = 0; id < num_entities; id++) {
+            nearby_characters.clear();
+            gather_nearby_characters(spatial_grid, all_characters, positions[id], interest_radius, id, nearby_ids,
+                                     nearby_characters);
+            full_snapshot_bytes +=
+                unacknowledged_world_replications[id].encode_next_snapshot(static_cast<int>(tick), nearby_characters)
+                    .size;
+        }
+    }
+
+    // what sending every other character's game update to everyone would have cost
+    GameUpdate game_update{positions[0].x, positions[0].y, velocities[0].x, velocities[0].y, 1};
+    double everything_bytes_per_tick = static_cast<double>(num_entities - 1) * wire_format::encode(game_update).size;
+
+    double seconds = num_ticks * tick_period;
+    return {8.0 * delta_bytes / num_entities / seconds, 8.0 * full_snapshot_bytes / num_entities / seconds,
+            8.0 * everything_bytes_per_tick / tick_period, encode_seconds / num_ticks};
+}
+
+} // namespace
+
+/**
+ * @brief bits per second each client receives in world snapshots at 10, 100 and 1000 entities, against full
+ * snapshots of the same nearby characters and against every character's game update going to everyone, and how long
+ * the server spends gathering and encoding them per tick
+ *
+ * @note characters are spread over a 100 by 100 world, so 1000 entities puts about 30 in each interest radius
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 3) {
+        std::cout << "usage: " << argv[0] << " [num_ticks] [round_trip_ticks]" << std::endl;
+        return 1;
+    }
+    unsigned int num_ticks = argc > 1 ? std::stoul(argv[1]) : 600;
+    unsigned int round_trip_ticks = argc > 2 ? std::stoul(argv[2]) : 6;
+
+    std::cout << std::format("{} ticks, {} tick round trip, bits per second per client\n", num_ticks,
+                             round_trip_ticks);
+    for (unsigned int num_entities : {10u, 100u, 1000u}) {
+        for (double moving_fraction : {0.1, 1.0}) {
+            ReplicationResult result = replicate(num_entities, moving_fraction, num_ticks, round_trip_ticks);
+            std::cout << std::format("{:>4} entities {:>3.0f}% moving: delta {:>8.0f} full snapshots {:>8.0f} "
+                                     "everything to everyone {:>10.0f}, encode {:.3f}ms per tick {:.2f}us per "
+                                     "client\n",
+                                     num_entities, 100 * moving_fraction, result.delta_bits,
+                                     result.full_snapshot_bits, result.everything_bits, 1000 * result.encode_seconds,
+                                     1e6 * result.encode_seconds / num_entities);
+        }
+    }
+    return 0;
+}
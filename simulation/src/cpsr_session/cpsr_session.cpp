@@ -0,0 +1,150 @@
+#include "cpsr_session.hpp"
+
+#include <Jolt/Jolt.h>
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <span>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/server_simulation/server_simulation.hpp"
+#include "utility/work_stealing_pool/work_stealing_pool.hpp"
+
+#include "../system_logic/physics/physics.hpp"
+
+SessionResult run_cpsr_session(const SessionSettings &settings) {
+    SessionResult result;
+
+    Physics physics;
+    WorkStealingPool pool(settings.num_server_threads);
+
+    const unsigned int client_id = 0;
+    const uint64_t server_character_id = client_id;
+    const uint64_t client_character_id = 1;
+    physics.create_character(server_character_id);
+    physics.create_character(client_character_id);
+
+    const double tick_period = 1 / settings.tick_rate;
+    ServerSimulation::Settings server_settings;
+    server_settings.tick_period = tick_period;
+    server_settings.buffer_input = settings.buffer_input;
+    ServerSimulation server(server_settings, physics.physics_system, pool);
+    ClientSimulation::Settings client_settings = settings.client;
+    client_settings.simulation_period = tick_period;
+    client_settings.server_tick_rate_hz = settings.tick_rate;
+    ClientSimulation client(client_settings, physics.physics_system,
+                            physics.client_id_to_physics_character[client_character_id]);
+
+    // separate seeds so the player's input doesn't change when the network settings do
+    SimulatedLink client_to_server(settings.client_to_server, settings.seed * 3 + 1);
+    SimulatedLink server_to_client(settings.server_to_client, settings.seed * 3 + 2);
+    std::mt19937_64 input_random_engine(settings.seed * 3);
+    std::bernoulli_distribution change_input(settings.input_change_probability);
+    std::bernoulli_distribution key_pressed(0.5);
+
+    // the real server sends this over the reliable channel, it's in the first batch of packets the client reads
+    std::vector<std::vector<char>> client_packets;
+    wire_format::EncodedMessage client_id_assignment =
+        server.connect_client(client_id, physics.client_id_to_physics_character[server_character_id]);
+    client_packets.emplace_back(client_id_assignment.data.data(),
+                                client_id_assignment.data.data() + client_id_assignment.size);
+    std::vector<std::span<const char>> client_packet_spans;
+
+    KeyboardUpdate held_input{client_id, 0};
+    auto sample_input = [&]() {
+        if (change_input(input_random_engine)) {
+            held_input.forward_pressed = key_pressed(input_random_engine);
+            held_input.backwards_pressed = key_pressed(input_random_engine);
+            held_input.left_pressed = key_pressed(input_random_engine);
+            held_input.right_pressed = key_pressed(input_random_engine);
+        }
+        return held_input;
+    };
+    // when each input was made, by id
+    std::vector<double> input_made_times;
+
+    const double client_tick_period = 1 / settings.client_thread_rate;
+    auto client_tick = [&](double now) {
+        std::vector<std::vector<char>> received = server_to_client.receive(now);
+        client_packets.insert(client_packets.end(), std::make_move_iterator(received.begin()),
+                              std::make_move_iterator(received.end()));
+        client_packet_spans.assign(client_packets.begin(), client_packets.end());
+
+        ClientSimulation::TickResult tick_result =
+            client.tick(client_tick_period, now, sample_input, client_packet_spans,
+                        [&](const wire_format::EncodedMessage &message) {
+                            client_to_server.send(message.data.data(), message.size, now);
+                        });
+        client_packets.clear();
+
+        if (tick_result.made_input.has_value()) {
+            input_made_times.push_back(now);
+        }
+        if (tick_result.reconciliation.has_value()) {
+            const ClientSimulation::Reconciliation &reconciliation = tick_result.reconciliation.value();
+            result.num_game_updates_reconciled++;
+            if (reconciliation.prediction_error.has_value()) {
+                result.prediction_errors.push_back(reconciliation.prediction_error.value());
+            }
+            if (reconciliation.replayed) {
+                result.num_replays++;
+                result.num_replayed_ticks += reconciliation.ticks_after_server_id;
+            }
+        }
+    };
+
+    const ServerSimulation::ConnectedClient &connected_client = *server.find_client(client_id);
+    auto server_tick = [&](double now) {
+        for (const std::vector<char> &packet : client_to_server.receive(now)) {
+            server.receive_packet(client_id, packet, now);
+        }
+
+        std::optional<int> last_consumed_id = connected_client.input_buffer.get_last_consumed_id();
+        uint64_t num_underruns_before = connected_client.input_buffer.get_num_underruns();
+        server.tick(static_cast<float>(tick_period), now,
+                    [&](unsigned int, const wire_format::EncodedMessage &message) {
+                        server_to_client.send(message.data.data(), message.size, now);
+                    });
+        std::optional<int> consumed_id = connected_client.input_buffer.get_last_consumed_id();
+        uint64_t num_underruns = connected_client.input_buffer.get_num_underruns() - num_underruns_before;
+
+        result.num_server_ticks++;
+        result.num_input_underruns += num_underruns;
+        if (not settings.buffer_input) {
+            const std::vector<KeyboardUpdate> &drained_inputs = connected_client.drained_inputs;
+            result.num_server_ticks_without_input += drained_inputs.empty();
+            result.max_inputs_per_server_tick = std::max(result.max_inputs_per_server_tick,
+                                                         static_cast<unsigned int>(drained_inputs.size()));
+            for (const KeyboardUpdate &input : drained_inputs) {
+                if (static_cast<size_t>(input.id) < input_made_times.size()) {
+                    result.input_delays.push_back(static_cast<float>(now - input_made_times[input.id]));
+                }
+            }
+        } else if (consumed_id == last_consumed_id or num_underruns > 0) {
+            result.num_server_ticks_without_input++;
+        } else {
+            // the jitter buffer never hands out more than one
+            result.max_inputs_per_server_tick = 1;
+            if (static_cast<size_t>(consumed_id.value()) < input_made_times.size()) {
+                result.input_delays.push_back(static_cast<float>(now - input_made_times[consumed_id.value()]));
+            }
+        }
+    };
+
+    uint64_t client_tick_index = 0;
+    for (unsigned int tick = 0; tick < settings.num_ticks; tick++) {
+        double now = tick * tick_period;
+        while (client_tick_index * client_tick_period <= now) {
+            client_tick(client_tick_index * client_tick_period);
+            client_tick_index++;
+        }
+        server_tick(now);
+    }
+
+    result.client_to_server_bytes = client_to_server.get_bytes_sent();
+    result.server_to_client_bytes = server_to_client.get_bytes_sent();
+    result.packets_lost = client_to_server.get_packets_lost() + server_to_client.get_packets_lost();
+    result.simulated_seconds = settings.num_ticks / settings.tick_rate;
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef CPSR_SESSION_HPP
+#define CPSR_SESSION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "system_logic/client_simulation/client_simulation.hpp"
+#include "../networking/simulated_link/simulated_link.hpp"
+
+struct SessionSettings {
+    uint64_t seed = 0;
+    // the server ticks at this rate and the client makes input at it, the virtual clock advances by one over it per
+    // server tick
+    double tick_rate = 60;
+    // how often the client's simulation thread ticks, see its main.cpp, it only makes an input every few of these
+    double client_thread_rate = 512;
+    unsigned int num_ticks = 60 * 60;
+    LinkSettings client_to_server;
+    LinkSettings server_to_client;
+    // chance per input made that the simulated player changes which keys they hold
+    double input_change_probability = 0.05;
+    // the server steps characters on a pool this big, the result never depends on it
+    unsigned int num_server_threads = 1;
+    // off has the server simulate everything that arrived since its last tick at once instead of one input out of the
+    // jitter buffer, see ServerSimulation::Settings
+    bool buffer_input = true;
+    // the same switches the client has, the simulation period and server tick rate in here are taken from tick_rate
+    ClientSimulation::Settings client;
+};
+
+struct SessionResult {
+    // how far our prediction was from the server at the id each game update was produced for, one per game update
+    // that we still had a prediction for
+    std::vector<float> prediction_errors;
+    uint64_t num_game_updates_reconciled = 0;
+    uint64_t num_replays = 0;
+    uint64_t num_replayed_ticks = 0;
+    uint64_t client_to_server_bytes = 0;
+    uint64_t server_to_client_bytes = 0;
+    uint64_t packets_lost = 0;
+    double simulated_seconds = 0;
+    // how long after the client made each input the server simulated it, one per input simulated that arrived in time
+    std::vector<float> input_delays;
+    uint64_t num_server_ticks = 0;
+    uint64_t num_server_ticks_without_input = 0;
+    unsigned int max_inputs_per_server_tick = 0;
+    // inputs that hadn't arrived by the tick that needed them, so the previous one was used in their place
+    uint64_t num_input_underruns = 0;
+};
+
+/**
+ * @brief runs one client against one server without a window, socket or wall clock
+ *
+ * @note both sides are the ClientSimulation and ServerSimulation the real binaries tick, only packets go over
+ * simulated links instead of sockets and the times come from a virtual clock. The client ticks at its thread rate and
+ * the server at its tick rate, the client goes first on a tie. The client id assignment the server sends reliably is
+ * handed straight to the client's first tick. The client and server characters live in the same physics world,
+ * characters don't collide with each other so they can't affect one another. Two runs with the same settings produce
+ * the same result.
+ */
+SessionResult run_cpsr_session(const SessionSettings &settings);
+
+#endif // CPSR_SESSION_HPP
@@ -0,0 +1,95 @@
+#include "cpsr_session/cpsr_session.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief runs many seeded sessions over the same simulated network and prints how the predictions held up, so
+ * changes to prediction or reconciliation can be compared without a window or a server
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 7) {
+        std::cout << "usage: " << argv[0] << " [num_sessions] [latency_ms] [jitter_ms] [loss] [reorder] [buffer_input]"
+                  << std::endl;
+        return 1;
+    }
+
+    unsigned int num_sessions = argc > 1 ? std::stoul(argv[1]) : 100;
+    LinkSettings link_settings;
+    link_settings.latency = (argc > 2 ? std::stod(argv[2]) : 50) / 1000;
+    link_settings.jitter = (argc > 3 ? std::stod(argv[3]) : 10) / 1000;
+    link_settings.loss = argc > 4 ? std::stod(argv[4]) : 0.02;
+    link_settings.reorder = argc > 5 ? std::stod(argv[5]) : 0.01;
+    bool buffer_input = argc > 6 ? std::stoi(argv[6]) != 0 : true;
+
+    std::vector<float> prediction_errors;
+    uint64_t num_game_updates_reconciled = 0;
+    uint64_t num_replays = 0;
+    uint64_t num_replayed_ticks = 0;
+    uint64_t client_to_server_bytes = 0;
+    uint64_t server_to_client_bytes = 0;
+    double simulated_seconds = 0;
+    std::vector<float> input_delays;
+    uint64_t num_server_ticks = 0;
+    uint64_t num_server_ticks_without_input = 0;
+    unsigned int max_inputs_per_server_tick = 0;
+    uint64_t num_input_underruns = 0;
+
+    SessionSettings session_settings;
+    session_settings.client_to_server = link_settings;
+    session_settings.server_to_client = link_settings;
+    session_settings.buffer_input = buffer_input;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int seed = 0; seed < num_sessions; seed++) {
+        session_settings.seed = seed;
+        SessionResult result = run_cpsr_session(session_settings);
+        prediction_errors.insert(prediction_errors.end(), result.prediction_errors.begin(),
+                                 result.prediction_errors.end());
+        num_game_updates_reconciled += result.num_game_updates_reconciled;
+        num_replays += result.num_replays;
+        num_replayed_ticks += result.num_replayed_ticks;
+        client_to_server_bytes += result.client_to_server_bytes;
+        server_to_client_bytes += result.server_to_client_bytes;
+        simulated_seconds += result.simulated_seconds;
+        input_delays.insert(input_delays.end(), result.input_delays.begin(), result.input_delays.end());
+        num_server_ticks += result.num_server_ticks;
+        num_server_ticks_without_input += result.num_server_ticks_without_input;
+        max_inputs_per_server_tick = std::max(max_inputs_per_server_tick, result.max_inputs_per_server_tick);
+        num_input_underruns += result.num_input_underruns;
+    }
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::sort(prediction_errors.begin(), prediction_errors.end());
+    std::sort(input_delays.begin(), input_delays.end());
+    auto percentile = [](const std::vector<float> &sorted_values, double fraction) {
+        if (sorted_values.empty()) {
+            return 0.0f;
+        }
+        return sorted_values[static_cast<size_t>(fraction * (sorted_values.size() - 1))];
+    };
+    size_t num_mispredictions =
+        prediction_errors.end() -
+        std::upper_bound(prediction_errors.begin(), prediction_errors.end(), session_settings.client.mispredict_epsilon);
+
+    std::cout << std::format("{} sessions, {:.0f}s simulated in {:.2f}s ({:.0f}x real time)\n", num_sessions,
+                             simulated_seconds, wall_seconds, simulated_seconds / wall_seconds);
+    std::cout << std::format("prediction error p50: {:.6f} p90: {:.6f} p99: {:.6f} max: {:.6f}\n",
+                             percentile(prediction_errors, 0.5), percentile(prediction_errors, 0.9),
+                             percentile(prediction_errors, 0.99), percentile(prediction_errors, 1));
+    std::cout << std::format("mispredicted {} of {} game updates, {} replays re-simulating {} ticks\n",
+                             num_mispredictions, num_game_updates_reconciled, num_replays, num_replayed_ticks);
+    std::cout << std::format("server simulated input {:.1f}ms after it was made p50, {:.1f}ms p99, {} underruns\n",
+                             1000 * percentile(input_delays, 0.5), 1000 * percentile(input_delays, 0.99),
+                             num_input_underruns);
+    std::cout << std::format("{} of {} server ticks simulated no input that arrived in time, at most {} inputs in "
+                             "one tick\n",
+                             num_server_ticks_without_input, num_server_ticks, max_inputs_per_server_tick);
+    std::cout << std::format("client to server: {:.0f}bps server to client: {:.0f}bps\n",
+                             8 * client_to_server_bytes / simulated_seconds,
+                             8 * server_to_client_bytes / simulated_seconds);
+    return 0;
+}
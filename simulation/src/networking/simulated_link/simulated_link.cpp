@@ -0,0 +1,36 @@
+#include "simulated_link.hpp"
+
+#include <functional>
+
+SimulatedLink::SimulatedLink(const LinkSettings &settings, uint64_t seed) : settings(settings), random_engine(seed) {}
+
+void SimulatedLink::send(const void *data, size_t size, double now) {
+    packets_sent++;
+    bytes_sent += size;
+
+    std::uniform_real_distribution<double> unit(0, 1);
+    // always draw every number so that changing one setting doesn't shift the randomness of the others
+    bool lost = unit(random_engine) < settings.loss;
+    double delay = settings.latency + settings.jitter * unit(random_engine);
+    if (unit(random_engine) < settings.reorder) {
+        delay += settings.latency;
+    }
+
+    if (lost) {
+        packets_lost++;
+        return;
+    }
+
+    const char *bytes = static_cast<const char *>(data);
+    in_flight_packets.push({now + delay, packets_sent, std::vector<char>(bytes, bytes + size)});
+}
+
+std::vector<std::vector<char>> SimulatedLink::receive(double now) {
+    std::vector<std::vector<char>> packets;
+    while (not in_flight_packets.empty() and in_flight_packets.top().delivery_time <= now) {
+        // top is const, but the packet is popped straight after so stealing its bytes is fine
+        packets.push_back(std::move(const_cast<InFlightPacket &>(in_flight_packets.top()).data));
+        in_flight_packets.pop();
+    }
+    return packets;
+}
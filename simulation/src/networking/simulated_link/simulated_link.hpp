@@ -0,0 +1,61 @@
+#ifndef SIMULATED_LINK_HPP
+#define SIMULATED_LINK_HPP
+
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <vector>
+
+struct LinkSettings {
+    // one way, in seconds
+    double latency = 0.05;
+    // every packet gets a uniformly random extra delay in [0, jitter] seconds, enough of it reorders packets by itself
+    double jitter = 0;
+    // chance a packet never arrives
+    double loss = 0;
+    // chance a packet is held back by an extra latency on top of everything else, so it lands behind later ones
+    double reorder = 0;
+};
+
+/**
+ * @brief a one way unreliable connection that lives in memory and runs on whatever clock the caller passes in,
+ * everything random comes from the seed so the same sends always produce the same deliveries
+ */
+class SimulatedLink {
+  public:
+    SimulatedLink(const LinkSettings &settings, uint64_t seed);
+
+    void send(const void *data, size_t size, double now);
+
+    /**
+     * @brief every packet due at or before now, in the order they arrive
+     */
+    std::vector<std::vector<char>> receive(double now);
+
+    uint64_t get_packets_sent() const { return packets_sent; }
+    uint64_t get_packets_lost() const { return packets_lost; }
+    uint64_t get_bytes_sent() const { return bytes_sent; }
+
+  private:
+    struct InFlightPacket {
+        double delivery_time;
+        // breaks ties between packets due at the same time so they come out in the order they were sent
+        uint64_t sequence;
+        std::vector<char> data;
+
+        bool operator>(const InFlightPacket &other) const {
+            return delivery_time != other.delivery_time ? delivery_time > other.delivery_time
+                                                        : sequence > other.sequence;
+        }
+    };
+
+    LinkSettings settings;
+    std::mt19937_64 random_engine;
+    std::priority_queue<InFlightPacket, std::vector<InFlightPacket>, std::greater<InFlightPacket>> in_flight_packets;
+
+    uint64_t packets_sent = 0;
+    uint64_t packets_lost = 0;
+    uint64_t bytes_sent = 0;
+};
+
+#endif // SIMULATED_LINK_HPP
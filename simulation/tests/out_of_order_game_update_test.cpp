@@ -0,0 +1,198 @@
+#include <Jolt/Jolt.h>
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/client_simulation/client_simulation.hpp"
+#include "system_logic/physics/physics.hpp"
+
+namespace {
+
+constexpr double delta_time = 1.0 / 60;
+
+struct Predicted {
+    glm::vec2 position;
+    glm::vec2 velocity;
+};
+
+/**
+ * @brief a client holding right, ticked once per input with whatever packets it's handed and remembering what it
+ * predicted at every id so game updates that agree with it can be made up
+ */
+class HeldRightClient {
+  public:
+    explicit HeldRightClient(const ClientSimulation::Settings &settings) {
+        physics.create_character(0);
+        client = std::make_unique<ClientSimulation>(settings, physics.physics_system,
+                                                    physics.client_id_to_physics_character[0]);
+    }
+
+    ClientSimulation::TickResult tick(const std::vector<wire_format::EncodedMessage> &messages) {
+        std::vector<std::span<const char>> packets;
+        for (const wire_format::EncodedMessage &message : messages) {
+            packets.emplace_back(message.data.data(), message.size);
+        }
+        ClientSimulation::TickResult result = client->tick(
+            delta_time, time, []() { return KeyboardUpdate{0, 0, false, false, false, true}; }, packets,
+            [](const wire_format::EncodedMessage &) {});
+        time += delta_time;
+        if (result.made_input.has_value()) {
+            predicted[result.made_input->id] = {client->get_position(), client->get_velocity()};
+        }
+        return result;
+    }
+
+    // what the server would send if it agreed with our prediction at id
+    wire_format::EncodedMessage agreeing_game_update(int id) const { return game_update(id, glm::vec2(0)); }
+
+    // what the server would send if it ended up off_by away from where we predicted we'd be at id
+    wire_format::EncodedMessage game_update(int id, glm::vec2 off_by) const {
+        const Predicted &at_id = predicted.at(id);
+        return wire_format::encode(GameUpdate{at_id.position.x + off_by.x, at_id.position.y + off_by.y,
+                                              at_id.velocity.x, at_id.velocity.y, id});
+    }
+
+    glm::vec2 get_position() const { return client->get_position(); }
+
+  private:
+    Physics physics;
+    std::unique_ptr<ClientSimulation> client;
+    double time = 0;
+    std::map<int, Predicted> predicted;
+};
+
+unsigned int num_failures = 0;
+
+void check(bool condition, const std::string &what) {
+    if (not condition) {
+        std::cout << "failed: " << what << std::endl;
+        num_failures++;
+    }
+}
+
+/**
+ * @brief one client gets game updates in order, the other gets the same ones plus older updates that were overtaken
+ * on the way and claim we were somewhere else entirely, the stale ones have to change nothing
+ */
+void check_stale_updates_are_ignored(bool reconcile_against_newest_update_only) {
+    std::string mode = reconcile_against_newest_update_only ? "newest update only" : "every update";
+    ClientSimulation::Settings settings;
+    settings.reconcile_against_newest_update_only = reconcile_against_newest_update_only;
+    HeldRightClient in_order(settings);
+    HeldRightClient out_of_order(settings);
+
+    std::vector<wire_format::EncodedMessage> assignment = {wire_format::encode(ClientIdAssignment{0})};
+    in_order.tick(assignment);
+    out_of_order.tick(assignment);
+    for (int tick = 1; tick < 30; tick++) {
+        in_order.tick({});
+        out_of_order.tick({});
+    }
+
+    in_order.tick({in_order.agreeing_game_update(20)});
+    ClientSimulation::TickResult result = out_of_order.tick({out_of_order.agreeing_game_update(20)});
+    check(result.reconciliation.has_value() and result.reconciliation->server_id == 20,
+          std::format("{}: an update for id 20 is reconciled against", mode));
+
+    // nowhere near where we were at id 10, acting on it would drag the character across the map
+    wire_format::EncodedMessage stale = wire_format::encode(GameUpdate{-50, 50, 0, 0, 10});
+    in_order.tick({});
+    result = out_of_order.tick({stale});
+    check(not result.reconciliation.has_value(),
+          std::format("{}: an update for id 10 arriving after id 20 is ignored", mode));
+
+    // the stale one read last in the tick, which is the one that used to be reconciled against when every update was
+    in_order.tick({in_order.agreeing_game_update(24)});
+    result = out_of_order.tick({out_of_order.agreeing_game_update(24), stale});
+    check(result.reconciliation.has_value() and result.reconciliation->server_id == 24,
+          std::format("{}: an update for id 10 read after id 24 in the same tick is ignored", mode));
+
+    for (int tick = 0; tick < 10; tick++) {
+        in_order.tick({});
+        out_of_order.tick({});
+    }
+    glm::vec2 expected = in_order.get_position();
+    glm::vec2 actual = out_of_order.get_position();
+    check(expected == actual, std::format("{}: ended up at ({}, {}) rather than ({}, {})", mode, actual.x, actual.y,
+                                          expected.x, expected.y));
+}
+
+/**
+ * @brief feeds a client that drops older game updates as they're read and one that keeps every one the same bunches
+ * of updates, read in a different order than they were sent and some of them disagreeing with the prediction, both
+ * have to reconcile against the newest of each bunch and end up in the same place
+ */
+void check_modes_agree() {
+    ClientSimulation::Settings newest_only_settings;
+    newest_only_settings.reconcile_against_newest_update_only = true;
+    ClientSimulation::Settings every_update_settings;
+    every_update_settings.reconcile_against_newest_update_only = false;
+    HeldRightClient newest_only(newest_only_settings);
+    HeldRightClient every_update(every_update_settings);
+
+    std::vector<wire_format::EncodedMessage> assignment = {wire_format::encode(ClientIdAssignment{0})};
+    newest_only.tick(assignment);
+    every_update.tick(assignment);
+    for (int tick = 1; tick < 30; tick++) {
+        newest_only.tick({});
+        every_update.tick({});
+    }
+
+    struct SentGameUpdate {
+        int id;
+        glm::vec2 off_by;
+    };
+    // the newest of each bunch is never read last, the first agrees with us and the rest don't
+    std::vector<std::vector<SentGameUpdate>> bunches = {
+        {{22, glm::vec2(0)}, {20, glm::vec2(0.5f, 0)}, {21, glm::vec2(0, 0.25f)}},
+        {{26, glm::vec2(0.1f, 0)}, {24, glm::vec2(0)}, {25, glm::vec2(0)}},
+        {{28, glm::vec2(0)}, {29, glm::vec2(0, -0.3f)}, {27, glm::vec2(0)}},
+    };
+    for (const std::vector<SentGameUpdate> &bunch : bunches) {
+        std::vector<wire_format::EncodedMessage> messages;
+        int newest_id = -1;
+        for (const SentGameUpdate &sent : bunch) {
+            messages.push_back(newest_only.game_update(sent.id, sent.off_by));
+            newest_id = std::max(newest_id, sent.id);
+        }
+        ClientSimulation::TickResult newest_only_result = newest_only.tick(messages);
+        ClientSimulation::TickResult every_update_result = every_update.tick(messages);
+        check(newest_only_result.reconciliation.has_value() and
+                  newest_only_result.reconciliation->server_id == newest_id,
+              std::format("newest update only: the bunch up to id {} is reconciled against its newest", newest_id));
+        check(every_update_result.reconciliation.has_value() and
+                  every_update_result.reconciliation->server_id == newest_id,
+              std::format("every update: the bunch up to id {} is reconciled against its newest", newest_id));
+        if (newest_only_result.reconciliation.has_value() and every_update_result.reconciliation.has_value()) {
+            check(newest_only_result.reconciliation->replayed == every_update_result.reconciliation->replayed,
+                  std::format("both modes replay the bunch up to id {} or neither does", newest_id));
+        }
+        check(newest_only.get_position() == every_update.get_position(),
+              std::format("both modes are in the same place after the bunch up to id {}", newest_id));
+    }
+}
+
+} // namespace
+
+/**
+ * @brief the network reorders packets, so a game update can arrive after a newer one the client has already
+ * reconciled against, by then the snapshots it would roll back to are gone and acting on it would only drag the
+ * character back, with and without reconcile_against_newest_update_only it has to be dropped. Within a tick the
+ * setting only changes how many updates are held on to, never which one is reconciled against.
+ */
+int main() {
+    check_stale_updates_are_ignored(true);
+    check_stale_updates_are_ignored(false);
+    check_modes_agree();
+    if (num_failures == 0) {
+        std::cout << "stale game updates were ignored and both modes reconciled against the newest" << std::endl;
+    }
+    return num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#include <Jolt/Jolt.h>
+
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "networking/messages/messages.hpp"
+#include "system_logic/client_simulation/client_simulation.hpp"
+#include "system_logic/physics/physics.hpp"
+
+namespace {
+
+constexpr double delta_time = 1.0 / 60;
+constexpr unsigned int num_ticks = 600;
+// far enough in that the character is moving and has touched whatever it's going to touch
+constexpr int rollback_id = 200;
+// how many ids past the rollback one the late client has predicted when the game update for it arrives
+constexpr int ticks_to_replay = 30;
+// where the server says we were at rollback_id relative to our prediction, far enough off that it can't be skipped
+const glm::vec2 server_position_offset(0.25f, -0.125f);
+const glm::vec2 server_velocity_offset(0.5f, 0);
+
+struct TickState {
+    glm::vec2 position;
+    glm::vec2 velocity;
+};
+
+bool bit_identical(const TickState &a, const TickState &b) {
+    return std::memcmp(&a.position, &b.position, sizeof(a.position)) == 0 and
+           std::memcmp(&a.velocity, &b.velocity, sizeof(a.velocity)) == 0;
+}
+
+/**
+ * @brief a client in its own physics world playing back the same random input as every other one made with the same
+ * seed, remembering where it was after each input
+ */
+class PlaybackClient {
+  public:
+    explicit PlaybackClient(const std::vector<KeyboardUpdate> &inputs) : inputs(inputs) {
+        physics.create_character(0);
+        client = std::make_unique<ClientSimulation>(ClientSimulation::Settings{}, physics.physics_system,
+                                                    physics.client_id_to_physics_character[0]);
+    }
+
+    ClientSimulation::TickResult tick(const std::vector<wire_format::EncodedMessage> &messages) {
+        std::vector<std::span<const char>> packets;
+        for (const wire_format::EncodedMessage &message : messages) {
+            packets.emplace_back(message.data.data(), message.size);
+        }
+        ClientSimulation::TickResult result = client->tick(
+            delta_time, time, [&]() { return inputs[num_inputs_sampled++ % inputs.size()]; }, packets,
+            [](const wire_format::EncodedMessage &) {});
+        time += delta_time;
+        if (result.made_input.has_value()) {
+            states[result.made_input->id] = get_state();
+        }
+        return result;
+    }
+
+    TickState get_state() const { return {client->get_position(), client->get_velocity()}; }
+    // where we were at the end of the tick that made id
+    const TickState *find_state(int id) const {
+        auto it = states.find(id);
+        return it == states.end() ? nullptr : &it->second;
+    }
+    std::optional<int> get_newest_id() const {
+        return states.empty() ? std::nullopt : std::optional<int>(states.rbegin()->first);
+    }
+
+  private:
+    Physics physics;
+    std::unique_ptr<ClientSimulation> client;
+    const std::vector<KeyboardUpdate> &inputs;
+    size_t num_inputs_sampled = 0;
+    double time = 0;
+    std::map<int, TickState> states;
+};
+
+unsigned int num_failures = 0;
+
+void check(bool condition, const std::string &what) {
+    if (not condition) {
+        std::cout << "failed: " << what << std::endl;
+        num_failures++;
+    }
+}
+
+std::string describe(const TickState &state) {
+    return std::format("({}, {}) moving ({}, {})", state.position.x, state.position.y, state.velocity.x,
+                       state.velocity.y);
+}
+
+} // namespace
+
+/**
+ * @brief two clients play the same ten seconds of random input and are told the server had them somewhere else at
+ * rollback_id, one as soon as it predicts it and one ticks_to_replay ids later, so the late one restores its character
+ * state from the snapshot at rollback_id and replays everything after it inside reconcile, while the early one has
+ * nothing to replay and just carries on predicting from the server's state
+ *
+ * @note every replayed tick has to land on exactly the same bits as predicting forward did, close isn't good enough
+ * because a replay that drifts turns into a misprediction a few ticks later
+ */
+int main() {
+    std::mt19937_64 random_engine(0);
+    std::bernoulli_distribution change_input(0.05);
+    std::bernoulli_distribution key_pressed(0.5);
+    std::vector<KeyboardUpdate> inputs;
+    KeyboardUpdate held_input{0, 0};
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        if (change_input(random_engine)) {
+            held_input.forward_pressed = key_pressed(random_engine);
+            held_input.backwards_pressed = key_pressed(random_engine);
+            held_input.left_pressed = key_pressed(random_engine);
+            held_input.right_pressed = key_pressed(random_engine);
+        }
+        inputs.push_back(held_input);
+    }
+
+    PlaybackClient early(inputs);
+    PlaybackClient late(inputs);
+    std::optional<wire_format::EncodedMessage> game_update;
+    glm::vec2 server_position;
+    glm::vec2 server_velocity;
+    bool early_reconciled = false;
+    bool late_reconciled = false;
+    for (unsigned int tick = 0; tick < num_ticks; tick++) {
+        std::vector<wire_format::EncodedMessage> early_messages;
+        std::vector<wire_format::EncodedMessage> late_messages;
+        if (tick == 0) {
+            early_messages.push_back(wire_format::encode(ClientIdAssignment{0}));
+            late_messages.push_back(wire_format::encode(ClientIdAssignment{0}));
+        }
+        // read by the tick that makes rollback_id + ticks_to_replay
+        if (game_update.has_value() and not late_reconciled and
+            late.get_newest_id() >= rollback_id + ticks_to_replay - 1) {
+            late_messages.push_back(game_update.value());
+        }
+
+        ClientSimulation::TickResult late_result = late.tick(late_messages);
+        if (late_result.made_input.has_value() and late_result.made_input->id == rollback_id) {
+            const TickState &predicted = *late.find_state(rollback_id);
+            glm::vec2 sent_position = predicted.position + server_position_offset;
+            glm::vec2 sent_velocity = predicted.velocity + server_velocity_offset;
+            game_update = wire_format::encode(
+                GameUpdate{sent_position.x, sent_position.y, sent_velocity.x, sent_velocity.y, rollback_id});
+            // what the client reads back is rounded to the wire format's fixed point
+            std::optional<GameUpdate> received =
+                wire_format::decode_game_update(game_update->data.data(), game_update->size);
+            server_position = glm::vec2(received->position_x, received->position_y);
+            server_velocity = glm::vec2(received->velocity_x, received->velocity_y);
+            // the early client makes rollback_id this same tick and reads the update right after, with nothing
+            // after it to replay it just takes on the server's state and predicts forward from there
+            early_messages.push_back(game_update.value());
+        }
+
+        ClientSimulation::TickResult early_result = early.tick(early_messages);
+        if (early_result.reconciliation.has_value()) {
+            early_reconciled = true;
+            check(early_result.reconciliation->ticks_after_server_id == 0,
+                  std::format("the early client had {} ticks to replay rather than none",
+                              early_result.reconciliation->ticks_after_server_id));
+            check(early.get_state().position == server_position and early.get_state().velocity == server_velocity,
+                  std::format("the early client is at {} after taking on the server's state at id {}",
+                              describe(early.get_state()), rollback_id));
+        }
+
+        if (not late_result.reconciliation.has_value()) {
+            continue;
+        }
+        late_reconciled = true;
+        const ClientSimulation::Reconciliation &reconciliation = late_result.reconciliation.value();
+        check(reconciliation.server_id == rollback_id,
+              std::format("the late client reconciled against id {}", reconciliation.server_id));
+        check(reconciliation.replayed, "the late client replayed a prediction the server disagreed with");
+        int newest_id = late.get_newest_id().value();
+        check(reconciliation.ticks_after_server_id == newest_id - rollback_id,
+              std::format("the late client replayed {} ticks, not the {} after id {}",
+                          reconciliation.ticks_after_server_id, newest_id - rollback_id, rollback_id));
+        const TickState *expected = early.find_state(newest_id);
+        if (expected == nullptr) {
+            check(false, std::format("the early client has no state for id {}", newest_id));
+            continue;
+        }
+        check(bit_identical(late.get_state(), *expected),
+              std::format("the late client replayed id {} to {} but predicting forward got {}", newest_id,
+                          describe(late.get_state()), describe(*expected)));
+    }
+    check(early_reconciled and late_reconciled, "both clients got the game update");
+
+    // everything predicted after the replay carries on from what it restored, so it has to keep agreeing too
+    unsigned int num_mismatched_ids = 0;
+    int newest_id = late.get_newest_id().value_or(0);
+    for (int id = rollback_id + ticks_to_replay + 1; id <= newest_id; id++) {
+        const TickState *late_state = late.find_state(id);
+        const TickState *early_state = early.find_state(id);
+        if (late_state == nullptr or early_state == nullptr or not bit_identical(*late_state, *early_state)) {
+            num_mismatched_ids++;
+        }
+    }
+    check(num_mismatched_ids == 0, std::format("{} ids after the replay differed between the clients",
+                                               num_mismatched_ids));
+
+    if (num_failures == 0) {
+        std::cout << std::format("replayed {} ticks from the state saved at id {}, then predicted {} more that all "
+                                 "matched\n",
+                                 ticks_to_replay, rollback_id, newest_id - rollback_id - ticks_to_replay);
+    }
+    return num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "networking/messages/messages.hpp"
+
+namespace {
+
+unsigned int num_failures = 0;
+
+void check(bool condition, const char *what) {
+    if (not condition) {
+        // the first few say what's wrong, thousands more of the same don't
+        if (num_failures < 10) {
+            std::cout << "failed: " << what << std::endl;
+        }
+        num_failures++;
+    }
+}
+
+bool same_keys(const KeyboardUpdate &a, const KeyboardUpdate &b) {
+    return a.forward_pressed == b.forward_pressed and a.backwards_pressed == b.backwards_pressed and
+           a.left_pressed == b.left_pressed and a.right_pressed == b.right_pressed;
+}
+
+KeyboardUpdate random_keyboard_update(std::mt19937_64 &random_engine) {
+    uint64_t bits = random_engine();
+    // ids are never negative, the decoder rejects anything that would come out as one
+    return {static_cast<unsigned int>(bits), static_cast<int>(bits >> 33), (bits & 1) != 0, (bits & 2) != 0,
+            (bits & 4) != 0, (bits & 8) != 0};
+}
+
+// fixed point rounds to the nearest step
+bool within_a_step(double decoded, double original) {
+    return std::abs(decoded - original) <= 0.5 / wire_format::fixed_point_scale;
+}
+
+} // namespace
+
+/**
+ * @brief encodes random messages of every kind, decodes them and checks they come back as they went in, then checks
+ * that every truncation of them and random garbage is rejected rather than read past the end or decoded as something
+ */
+int main() {
+    std::mt19937_64 random_engine(0);
+    std::uniform_real_distribution<double> position(-1000, 1000);
+    std::uniform_real_distribution<double> velocity(-1, 1);
+    std::vector<KeyboardUpdate> decoded_keyboard_updates;
+    WorldSnapshot decoded_world_snapshot;
+
+    for (unsigned int i = 0; i < 20000; i++) {
+        ClientIdAssignment client_id_assignment{static_cast<unsigned int>(random_engine())};
+        wire_format::EncodedMessage message = wire_format::encode(client_id_assignment);
+        std::optional<ClientIdAssignment> decoded_client_id_assignment =
+            wire_format::decode_client_id_assignment(message.data.data(), message.size);
+        check(decoded_client_id_assignment.has_value() and
+                  decoded_client_id_assignment->client_id == client_id_assignment.client_id,
+              "client id assignment round trips");
+
+        KeyboardUpdate keyboard_update = random_keyboard_update(random_engine);
+        message = wire_format::encode(keyboard_update);
+        std::optional<KeyboardUpdate> decoded_keyboard_update =
+            wire_format::decode_keyboard_update(message.data.data(), message.size);
+        check(decoded_keyboard_update.has_value() and
+                  decoded_keyboard_update->client_id == keyboard_update.client_id and
+                  decoded_keyboard_update->id == keyboard_update.id and
+                  same_keys(decoded_keyboard_update.value(), keyboard_update),
+              "keyboard update round trips");
+        check(not wire_format::decode_game_update(message.data.data(), message.size).has_value(),
+              "a keyboard update doesn't decode as a game update");
+        for (size_t size = 0; size < message.size; size++) {
+            check(not wire_format::decode_keyboard_update(message.data.data(), size).has_value(),
+                  "a cut short keyboard update is rejected");
+        }
+
+        GameUpdate game_update{position(random_engine), position(random_engine), velocity(random_engine),
+                               velocity(random_engine),  static_cast<int>(random_engine() >> 33),
+                               velocity(random_engine) * 16};
+        message = wire_format::encode(game_update);
+        std::optional<GameUpdate> decoded_game_update =
+            wire_format::decode_game_update(message.data.data(), message.size);
+        check(decoded_game_update.has_value() and
+                  decoded_game_update->last_id_used_to_produce_this_update ==
+                      game_update.last_id_used_to_produce_this_update and
+                  within_a_step(decoded_game_update->position_x, game_update.position_x) and
+                  within_a_step(decoded_game_update->position_y, game_update.position_y) and
+                  within_a_step(decoded_game_update->velocity_x, game_update.velocity_x) and
+                  within_a_step(decoded_game_update->velocity_y, game_update.velocity_y) and
+                  within_a_step(decoded_game_update->input_lead, game_update.input_lead),
+              "game update round trips");
+        for (size_t size = 0; size < message.size; size++) {
+            check(not wire_format::decode_game_update(message.data.data(), size).has_value(),
+                  "a cut short game update is rejected");
+        }
+
+        // garbage must be rejected or decoded into something, never read past the end, run under asan to be sure
+        char garbage[wire_format::max_message_size];
+        size_t garbage_size = random_engine() % sizeof(garbage);
+        for (size_t j = 0; j < garbage_size; j++) {
+            garbage[j] = static_cast<char>(random_engine());
+        }
+        wire_format::peek_message_type(garbage, garbage_size);
+        wire_format::decode_client_id_assignment(garbage, garbage_size);
+        wire_format::decode_keyboard_update(garbage, garbage_size);
+        wire_format::decode_game_update(garbage, garbage_size);
+        int acknowledged_world_snapshot_id;
+        wire_format::decode_keyboard_update_batch(garbage, garbage_size, decoded_keyboard_updates,
+                                                  acknowledged_world_snapshot_id);
+        wire_format::peek_world_snapshot_header(garbage, garbage_size);
+        wire_format::decode_world_snapshot(garbage, garbage_size, nullptr, decoded_world_snapshot);
+    }
+
+    std::vector<KeyboardUpdate> keyboard_updates;
+    for (unsigned int i = 0; i < 2000; i++) {
+        // anywhere from every input differing to the same keys held throughout, and past the most a batch carries
+        size_t num_keyboard_updates = random_engine() % (wire_format::max_keyboard_updates_per_batch + 50);
+        int first_id = static_cast<int>(random_engine() % 1000000);
+        double change_probability = static_cast<double>(random_engine() % 5) / 4;
+        std::bernoulli_distribution change_keys(change_probability);
+        KeyboardUpdate held_keys = random_keyboard_update(random_engine);
+        keyboard_updates.clear();
+        for (size_t j = 0; j < num_keyboard_updates; j++) {
+            if (change_keys(random_engine)) {
+                held_keys = random_keyboard_update(random_engine);
+            }
+            held_keys.client_id = 7;
+            held_keys.id = first_id + static_cast<int>(j);
+            keyboard_updates.push_back(held_keys);
+        }
+        int acknowledged_world_snapshot_id = static_cast<int>(random_engine() % 100000) - 1;
+
+        wire_format::EncodedMessage message =
+            wire_format::encode_keyboard_update_batch(7, keyboard_updates, acknowledged_world_snapshot_id);
+        int decoded_acknowledged_world_snapshot_id;
+        bool decoded = wire_format::decode_keyboard_update_batch(message.data.data(), message.size,
+                                                                 decoded_keyboard_updates,
+                                                                 decoded_acknowledged_world_snapshot_id);
+        // only the newest max_keyboard_updates_per_batch go out
+        size_t num_dropped = num_keyboard_updates > wire_format::max_keyboard_updates_per_batch
+                                 ? num_keyboard_updates - wire_format::max_keyboard_updates_per_batch
+                                 : 0;
+        bool round_trips = decoded and decoded_acknowledged_world_snapshot_id == acknowledged_world_snapshot_id and
+                           decoded_keyboard_updates.size() == num_keyboard_updates - num_dropped;
+        for (size_t j = 0; round_trips and j < decoded_keyboard_updates.size(); j++) {
+            const KeyboardUpdate &original = keyboard_updates[j + num_dropped];
+            const KeyboardUpdate &decoded_keyboard_update = decoded_keyboard_updates[j];
+            round_trips = decoded_keyboard_update.client_id == 7 and decoded_keyboard_update.id == original.id and
+                          same_keys(decoded_keyboard_update, original);
+        }
+        check(round_trips, "keyboard update batch round trips");
+        for (size_t size = 0; size < message.size; size++) {
+            check(not wire_format::decode_keyboard_update_batch(message.data.data(), size, decoded_keyboard_updates,
+                                                                decoded_acknowledged_world_snapshot_id),
+                  "a cut short batch is rejected");
+        }
+    }
+
+    // ids go out as unsigned 32 bit, anything past INT_MAX would come out negative and wrap the jitter buffer's
+    // arithmetic, so it has to be rejected rather than decoded
+    for (int id : {INT_MAX, INT_MIN, -1}) {
+        wire_format::EncodedMessage message = wire_format::encode(KeyboardUpdate{7, id});
+        std::optional<KeyboardUpdate> decoded_keyboard_update =
+            wire_format::decode_keyboard_update(message.data.data(), message.size);
+        check(id >= 0 ? decoded_keyboard_update.has_value() and decoded_keyboard_update->id == id
+                      : not decoded_keyboard_update.has_value(),
+              "a keyboard update decodes only if its id fits in an int");
+    }
+    for (auto [first_id, num_keyboard_updates] : {std::pair{static_cast<uint32_t>(INT_MAX), 1u},
+                                                  {static_cast<uint32_t>(INT_MAX) - 2, 3u},
+                                                  {static_cast<uint32_t>(INT_MAX) - 2, 4u},
+                                                  {static_cast<uint32_t>(INT_MAX) + 1, 1u},
+                                                  {UINT32_MAX, 2u}}) {
+        keyboard_updates.clear();
+        for (uint32_t j = 0; j < num_keyboard_updates; j++) {
+            keyboard_updates.push_back(KeyboardUpdate{7, static_cast<int>(first_id + j)});
+        }
+        wire_format::EncodedMessage message = wire_format::encode_keyboard_update_batch(7, keyboard_updates);
+        int decoded_acknowledged_world_snapshot_id;
+        bool decoded = wire_format::decode_keyboard_update_batch(message.data.data(), message.size,
+                                                                 decoded_keyboard_updates,
+                                                                 decoded_acknowledged_world_snapshot_id);
+        bool fits = static_cast<uint64_t>(first_id) + num_keyboard_updates - 1 <= INT_MAX;
+        check(fits ? decoded and decoded_keyboard_updates.back().id == INT_MAX : not decoded,
+              std::format("a batch of {} from id {} decodes only if its last id fits in an int", num_keyboard_updates,
+                          first_id)
+                  .c_str());
+    }
+
+    std::cout << std::format("{} checks failed\n", num_failures);
+    return num_failures == 0 ? 0 : 1;
+}